@@ -0,0 +1,492 @@
+/* POLYBENCH/GPU-OPENMP
+ *
+ * This file is a part of the Polybench/GPU-OpenMP suite
+ *
+ * Contact:
+ * William Killian <killian@udel.edu>
+ *
+ * Copyright 2013, The University of Delaware
+ */
+#define EXTRALARGE_DATASET
+/* Distributed correlation: no rank holds the data matrix or symmat,
+   only its rows of data and its blocks of symmat, so the sizes are set
+   at run time. */
+#ifndef POLYBENCH_USE_C99_PROTO
+# define POLYBENCH_USE_C99_PROTO
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <math.h>
+#include <mpi.h>
+
+/* Include polybench common header. */
+#include <polybench.h>
+
+/* Include benchmark-specific header. */
+/* Default data type is double, default size is 4000. */
+#include "correlation.h"
+#include "correlation_moments.h"
+#include "correlation_syrk.h"
+
+/* MPI type of DATA_TYPE. */
+#ifndef MPI_DATA_TYPE
+# define MPI_DATA_TYPE MPI_FLOAT
+#endif
+
+/* The N rows of data are split in contiguous ranges over the ranks.
+   The column moments are reduced by a single MPI_Allreduce, and symmat
+   is cut in CORRELATION_BLOCK x CORRELATION_BLOCK blocks (default:
+   512, rounded to SYRK_TILE): only the blocks of its upper triangle are
+   computed, numbered row by row and split in equal contiguous ranges
+   over the ranks, as the tiles of correlation_syrk_tiles over the
+   threads. Every rank computes the product of its rows for each block
+   in turn, and reduces it to the owner of the block while computing the
+   next one. symmat is written to CORRELATION_OUTPUT (M rows of M
+   DATA_TYPE) if set, and gathered on rank 0 only to be checked with
+   POLYBENCH_VERIFY or dumped. */
+#ifndef MPI_BLOCK
+# define MPI_BLOCK 512
+#endif
+
+
+/* Distribution of data and symmat over the ranks. */
+struct correlation_dist
+{
+  int rank;
+  int size;
+  long long n0;
+  int nl;
+  MPI_Datatype moments_type;
+  MPI_Op moments_op;
+  int bs;
+  int nb;
+  long long nb_blocks;
+  long long first;
+  long long last;
+  DATA_TYPE* blocks;
+  DATA_TYPE* slots[2];
+};
+
+
+/* Array initialization: rows n0..n0+nl-1 of the PolyBench input. */
+static
+void init_array (int m,
+		 long long n0,
+		 int nl,
+		 DATA_TYPE *float_n,
+		 DATA_TYPE POLYBENCH_2D(data,N,M,nl,m))
+{
+  int i, j;
+
+  *float_n = 1.2;
+
+  for (i = 0; i < nl; i++)
+    for (j = 0; j < m; j++)
+      data[i][j] = ((DATA_TYPE) (n0 + i)*j) / m;
+}
+
+
+/* DCE code. Must scan the entire live-out data.
+   Can be used also to check the correctness of the output. */
+static
+void print_array(int m,
+		 DATA_TYPE POLYBENCH_2D(symmat,M,M,m,m))
+
+{
+  int i, j;
+
+  for (i = 0; i < m; i++)
+    for (j = 0; j < m; j++) {
+      fprintf (stderr, DATA_PRINTF_MODIFIER, symmat[i][j]);
+      if ((i * m + j) % 20 == 0) fprintf (stderr, "\n");
+    }
+  fprintf (stderr, "\n");
+}
+
+
+/* Merge the moments of the ranks: a count followed by mu and m2. */
+static
+void moments_merge_op(void* in, void* inout, int* len, MPI_Datatype* type)
+{
+  int size, m, k;
+
+  MPI_Type_size (*type, &size);
+  m = (size - sizeof(long long)) / (2 * sizeof(DATA_TYPE));
+  for (k = 0; k < *len; k++)
+    {
+      char* a = (char*) inout + (size_t) k * size;
+      char* b = (char*) in + (size_t) k * size;
+      long long na, nb;
+      DATA_TYPE* mua = (DATA_TYPE*) (a + sizeof(long long));
+      DATA_TYPE* mub = (DATA_TYPE*) (b + sizeof(long long));
+
+      memcpy (&na, a, sizeof(na));
+      memcpy (&nb, b, sizeof(nb));
+      correlation_moments_merge (m, na, mua, mua + m, nb, mub, mub + m);
+      na += nb;
+      memcpy (a, &na, sizeof(na));
+    }
+}
+
+
+/* Row b1 and column b2 of block t of the upper triangle of nb x nb
+   blocks. */
+static
+void block_coords(int nb, long long t, int* b1, int* b2)
+{
+  *b1 = 0;
+  while (t >= nb - *b1)
+    t -= nb - (*b1)++;
+  *b2 = *b1 + t;
+}
+
+
+/* Rank owning block t. */
+static
+int block_owner(struct correlation_dist* d, long long t)
+{
+  return ((t + 1) * d->size + d->nb_blocks - 1) / d->nb_blocks - 1;
+}
+
+
+/* c = data(:, j1..j1+bs-1)' data(:, j2..j2+bs-1), by SYRK_TILE tiles
+   (upper tiles only on a diagonal block). Must be called by all the
+   threads of a parallel region: the master thread also polls the
+   pending reductions between its tiles, to progress them. */
+static
+void gram_block(int m, int nl, int j1, int j2, int bs,
+		DATA_TYPE POLYBENCH_2D(data,N,M,nl,m),
+		DATA_TYPE* c, MPI_Request* pending)
+{
+  DATA_TYPE a[SYRK_DEPTH][SYRK_TILE] __attribute__ ((aligned (64)));
+  DATA_TYPE b[SYRK_DEPTH][SYRK_TILE] __attribute__ ((aligned (64)));
+  DATA_TYPE ct[SYRK_TILE][SYRK_TILE] __attribute__ ((aligned (64)));
+  int nt = bs / SYRK_TILE, t;
+
+  #pragma omp for POLYBENCH_SCHEDULE(dynamic,1)
+  for (t = 0; t < nt * nt; t++)
+    {
+      int x0 = t / nt * SYRK_TILE, y0 = t % nt * SYRK_TILE;
+      int i0, kb, x, flag;
+
+      if (j1 == j2 && y0 < x0)
+	continue;
+      memset (ct, 0, sizeof(ct));
+      for (i0 = 0; i0 < nl; i0 += SYRK_DEPTH)
+	{
+	  kb = nl - i0 < SYRK_DEPTH ? nl - i0 : SYRK_DEPTH;
+	  correlation_syrk_pack (m, nl, i0, kb, j1 + x0, data, a);
+	  if (j1 + x0 == j2 + y0)
+	    correlation_syrk_block (kb, 1, a, a, ct);
+	  else
+	    {
+	      correlation_syrk_pack (m, nl, i0, kb, j2 + y0, data, b);
+	      correlation_syrk_block (kb, 0, a, b, ct);
+	    }
+	}
+      for (x = 0; x < SYRK_TILE; x++)
+	memcpy (c + (size_t) (x0 + x) * bs + y0, ct[x],
+		SYRK_TILE * sizeof(DATA_TYPE));
+#ifdef _OPENMP
+      if (omp_get_thread_num () == 0)
+#endif
+	MPI_Testall (2, pending, &flag, MPI_STATUSES_IGNORE);
+    }
+}
+
+
+/* Main computational kernel. The whole function will be timed,
+   including the call and return. */
+static
+void kernel_correlation(int m, long long n, int nl,
+			DATA_TYPE float_n,
+			struct correlation_dist* d,
+			DATA_TYPE POLYBENCH_2D(data,N,M,nl,m),
+			DATA_TYPE POLYBENCH_1D(mean,M,m),
+			DATA_TYPE POLYBENCH_1D(stddev,M,m))
+{
+  DATA_TYPE eps = 0.1f;
+  size_t bytes = sizeof(long long) + 2 * (size_t) m * sizeof(DATA_TYPE);
+  char* moments = (char*) polybench_alloc_data (bytes, 1);
+  DATA_TYPE* mu = (DATA_TYPE*) (moments + sizeof(long long));
+  DATA_TYPE* m2 = mu + m;
+  MPI_Request req[2] = { MPI_REQUEST_NULL, MPI_REQUEST_NULL };
+  long long count = nl, t;
+  int bs = d->bs, i, j;
+
+  /* Moments of the local rows, merged over the ranks. */
+  #pragma omp parallel
+  {
+    polybench_region_begin ("moments");
+    correlation_moments_rows (m, nl, data, mu, m2);
+    polybench_region_end ("moments");
+  }
+  memcpy (moments, &count, sizeof(count));
+  MPI_Allreduce (MPI_IN_PLACE, moments, 1, d->moments_type, d->moments_op,
+		 MPI_COMM_WORLD);
+  correlation_moments_finish (m, n, float_n, eps, mu, m2, mean, stddev);
+
+  #pragma omp parallel private (t)
+  {
+    /* Center and reduce the column vectors. */
+    polybench_region_begin ("center");
+    #pragma omp for private (j) POLYBENCH_SCHEDULE_DEFAULT
+    for (i = 0; i < nl; i++)
+      for (j = 0; j < _PB_M; j++)
+	{
+	  data[i][j] -= mean[j];
+	  data[i][j] /= sqrt(float_n) * stddev[j];
+	}
+    polybench_region_end ("center");
+
+    /* Local products of the blocks, each reduced to its owner while the
+       next one is computed in the other slot. */
+    polybench_region_begin ("symmat");
+    for (t = 0; t < d->nb_blocks; t++)
+      {
+	int b1, b2;
+
+	block_coords (d->nb, t, &b1, &b2);
+	#pragma omp master
+	MPI_Wait (&req[t % 2], MPI_STATUS_IGNORE);
+	#pragma omp barrier
+	gram_block (m, nl, b1 * bs, b2 * bs, bs, data, d->slots[t % 2], req);
+	#pragma omp master
+	{
+	  int owner = block_owner (d, t);
+	  MPI_Ireduce (d->slots[t % 2], owner == d->rank
+		       ? d->blocks + (size_t) (t - d->first) * bs * bs : NULL,
+		       bs * bs, MPI_DATA_TYPE, MPI_SUM, owner, MPI_COMM_WORLD,
+		       &req[t % 2]);
+	}
+      }
+    #pragma omp master
+    MPI_Waitall (2, req, MPI_STATUSES_IGNORE);
+    #pragma omp barrier
+
+    /* Unit diagonal. */
+    #pragma omp for POLYBENCH_SCHEDULE_DEFAULT
+    for (t = d->first; t < d->last; t++)
+      {
+	int b1, b2, x;
+
+	block_coords (d->nb, t, &b1, &b2);
+	if (b1 == b2)
+	  for (x = 0; x < bs; x++)
+	    d->blocks[(size_t) (t - d->first) * bs * bs + (size_t) x * bs + x] = 1.0;
+      }
+    polybench_region_end ("symmat");
+  }
+  polybench_free_data (moments);
+}
+
+
+/* Write the blocks of the rank, and their transposes, to the M x M
+   file. */
+static
+void write_blocks(int m, struct correlation_dist* d, const char* output)
+{
+  MPI_File fh;
+  long long t;
+  int bs = d->bs;
+  DATA_TYPE* tr = d->slots[0];
+
+  if (MPI_File_open (MPI_COMM_WORLD, (char*) output,
+		     MPI_MODE_WRONLY | MPI_MODE_CREATE, MPI_INFO_NULL, &fh))
+    {
+      fprintf (stderr, "correlation: cannot open %s\n", output);
+      MPI_Abort (MPI_COMM_WORLD, 1);
+    }
+  MPI_File_set_size (fh, (MPI_Offset) m * m * sizeof(DATA_TYPE));
+  for (t = d->first; t < d->last; t++)
+    {
+      DATA_TYPE* c = d->blocks + (size_t) (t - d->first) * bs * bs;
+      int b1, b2, x, y, w1, w2;
+
+      block_coords (d->nb, t, &b1, &b2);
+      w1 = m - b1 * bs < bs ? m - b1 * bs : bs;
+      w2 = m - b2 * bs < bs ? m - b2 * bs : bs;
+      for (x = 0; x < bs; x++)
+	for (y = 0; y < bs; y++)
+	  tr[(size_t) y * bs + x] = c[(size_t) x * bs + y];
+      /* A diagonal block is only valid above its diagonal. */
+      if (b1 == b2)
+	for (x = 0; x < bs; x++)
+	  for (y = 0; y < x; y++)
+	    c[(size_t) x * bs + y] = tr[(size_t) x * bs + y];
+      for (x = 0; x < w1; x++)
+	MPI_File_write_at (fh, ((MPI_Offset) (b1 * bs + x) * m + b2 * bs)
+			   * sizeof(DATA_TYPE), c + (size_t) x * bs, w2,
+			   MPI_DATA_TYPE, MPI_STATUS_IGNORE);
+      if (b1 != b2)
+	for (y = 0; y < w2; y++)
+	  MPI_File_write_at (fh, ((MPI_Offset) (b2 * bs + y) * m + b1 * bs)
+			     * sizeof(DATA_TYPE), tr + (size_t) y * bs, w1,
+			     MPI_DATA_TYPE, MPI_STATUS_IGNORE);
+    }
+  MPI_File_close (&fh);
+}
+
+
+/* Gather the blocks on rank 0, into symmat. */
+static
+void gather_blocks(int m, struct correlation_dist* d,
+		   DATA_TYPE POLYBENCH_2D(symmat,M,M,m,m))
+{
+  int bs = d->bs, r;
+  int* counts = NULL;
+  int* displs = NULL;
+  DATA_TYPE* all = NULL;
+  long long t;
+
+  if (d->rank == 0)
+    {
+      counts = (int*) malloc (2 * d->size * sizeof(int));
+      displs = counts + d->size;
+      for (r = 0; r < d->size; r++)
+	{
+	  displs[r] = d->nb_blocks * r / d->size * bs * bs;
+	  counts[r] = d->nb_blocks * (r + 1) / d->size * bs * bs - displs[r];
+	}
+      all = (DATA_TYPE*) polybench_alloc_data (d->nb_blocks * bs * bs,
+					       sizeof(DATA_TYPE));
+    }
+  MPI_Gatherv (d->blocks, (d->last - d->first) * bs * bs, MPI_DATA_TYPE,
+	       all, counts, displs, MPI_DATA_TYPE, 0, MPI_COMM_WORLD);
+  if (d->rank)
+    return;
+  for (t = 0; t < d->nb_blocks; t++)
+    {
+      DATA_TYPE* c = all + (size_t) t * bs * bs;
+      int b1, b2, x, y;
+
+      block_coords (d->nb, t, &b1, &b2);
+      for (x = 0; x < bs && b1 * bs + x < m; x++)
+	for (y = b1 == b2 ? x : 0; y < bs && b2 * bs + y < m; y++)
+	  {
+	    symmat[b1 * bs + x][b2 * bs + y] = c[(size_t) x * bs + y];
+	    symmat[b2 * bs + y][b1 * bs + x] = c[(size_t) x * bs + y];
+	  }
+    }
+  polybench_free_data (all);
+  free (counts);
+}
+
+
+int main(int argc, char** argv)
+{
+  /* Retrieve problem size. */
+  long long n = POLYBENCH_SIZE(N);
+  int m = POLYBENCH_SIZE(M);
+  const char* output = getenv ("CORRELATION_OUTPUT");
+  const char* block = getenv ("CORRELATION_BLOCK");
+  struct correlation_dist d;
+  int provided, gather = getenv ("POLYBENCH_VERIFY") != NULL;
+  size_t block_size;
+
+  MPI_Init_thread (&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+  if (provided < MPI_THREAD_FUNNELED)
+    {
+      fprintf (stderr, "correlation: MPI_THREAD_FUNNELED is not supported\n");
+      MPI_Abort (MPI_COMM_WORLD, 1);
+    }
+  MPI_Comm_rank (MPI_COMM_WORLD, &d.rank);
+  MPI_Comm_size (MPI_COMM_WORLD, &d.size);
+#ifdef POLYBENCH_DUMP_ARRAYS
+  gather = 1;
+#endif
+
+  /* Rows of the rank, and blocks of symmat. */
+  d.n0 = n * d.rank / d.size;
+  d.nl = n * (d.rank + 1) / d.size - d.n0;
+  d.bs = block && atoi (block) > 0 ? atoi (block) : MPI_BLOCK;
+  if (d.bs > m)
+    d.bs = m;
+  d.bs = (d.bs + SYRK_TILE - 1) / SYRK_TILE * SYRK_TILE;
+  d.nb = (m + d.bs - 1) / d.bs;
+  d.nb_blocks = (long long) d.nb * (d.nb + 1) / 2;
+  d.first = d.nb_blocks * d.rank / d.size;
+  d.last = d.nb_blocks * (d.rank + 1) / d.size;
+  block_size = (size_t) d.bs * d.bs;
+  d.blocks = (DATA_TYPE*) polybench_alloc_data
+    ((d.last - d.first) * block_size, sizeof(DATA_TYPE));
+  d.slots[0] = (DATA_TYPE*) polybench_alloc_data (block_size, sizeof(DATA_TYPE));
+  d.slots[1] = (DATA_TYPE*) polybench_alloc_data (block_size, sizeof(DATA_TYPE));
+  MPI_Type_contiguous (sizeof(long long) + 2 * m * sizeof(DATA_TYPE),
+		       MPI_BYTE, &d.moments_type);
+  MPI_Type_commit (&d.moments_type);
+  MPI_Op_create (moments_merge_op, 0, &d.moments_op);
+
+  /* Flops and compulsory memory traffic of all the ranks, for the
+     GFLOP/s and roofline reports. */
+  polybench_set_program_flops ((double) n * m * (m - 1) + 6.0 * n * m + 4.0 * m);
+  polybench_set_program_bytes ((2.0 * n * m + (double) m * m) * sizeof(DATA_TYPE));
+
+  /* Variable declaration/allocation. */
+  DATA_TYPE float_n;
+  int nl = d.nl;
+  POLYBENCH_2D_ARRAY_DECL(data,DATA_TYPE,N,M,nl,m);
+  POLYBENCH_1D_ARRAY_DECL(mean,DATA_TYPE,M,m);
+  POLYBENCH_1D_ARRAY_DECL(stddev,DATA_TYPE,M,m);
+  DATA_TYPE POLYBENCH_2D(POLYBENCH_DECL_VAR(symmat),M,M,m,m) = NULL;
+
+  /* Run the kernel once per repetition (see polybench.h). */
+  polybench_repeat
+    {
+      /* Initialize array(s). */
+      init_array (m, d.n0, nl, &float_n, POLYBENCH_ARRAY(data));
+      MPI_Barrier (MPI_COMM_WORLD);
+
+      /* Start timer. */
+      polybench_start_instruments;
+      /* Run kernel. */
+      kernel_correlation (m, n, nl, float_n, &d,
+			  POLYBENCH_ARRAY(data),
+			  POLYBENCH_ARRAY(mean),
+			  POLYBENCH_ARRAY(stddev));
+      MPI_Barrier (MPI_COMM_WORLD);
+
+      /* Stop timer. */
+      polybench_stop_instruments;
+    }
+  /* Print timer. */
+  if (d.rank == 0)
+    {
+      polybench_print_instruments;
+    }
+
+  if (output)
+    write_blocks (m, &d, output);
+  if (gather)
+    {
+      if (d.rank == 0)
+	symmat = POLYBENCH_ALLOC_2D_ARRAY(m, m, DATA_TYPE);
+      gather_blocks (m, &d, symmat ? POLYBENCH_ARRAY(symmat) : NULL);
+    }
+  if (symmat)
+    {
+      /* Prevent dead-code elimination. All live-out data must be printed
+	 by the function call in argument. */
+      polybench_prevent_dce(print_array(m, POLYBENCH_ARRAY(symmat)));
+
+      /* Check the output, as selected with POLYBENCH_VERIFY. */
+      polybench_verify_2d (symmat, m, m);
+      POLYBENCH_FREE_ARRAY(symmat);
+    }
+
+  /* Be clean. */
+  POLYBENCH_FREE_ARRAY(data);
+  POLYBENCH_FREE_ARRAY(mean);
+  POLYBENCH_FREE_ARRAY(stddev);
+  polybench_free_data (d.blocks);
+  polybench_free_data (d.slots[0]);
+  polybench_free_data (d.slots[1]);
+  MPI_Op_free (&d.moments_op);
+  MPI_Type_free (&d.moments_type);
+  MPI_Finalize ();
+
+  return 0;
+}
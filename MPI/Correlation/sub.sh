@@ -0,0 +1,5 @@
+srun --time=00:15:00 --mem 32G -N 4 -n 8 -c 12 ./subMPI.sh
+
+mv correlation_mpi.prv ${STORE}/MPItraces/correlation_mpi.prv
+mv correlation_mpi.pcf ${STORE}/MPItraces/correlation_mpi.pcf
+mv correlation_mpi.row ${STORE}/MPItraces/correlation_mpi.row
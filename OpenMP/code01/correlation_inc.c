@@ -0,0 +1,232 @@
+/* POLYBENCH/GPU-OPENMP
+ *
+ * This file is a part of the Polybench/GPU-OpenMP suite
+ *
+ * Contact:
+ * William Killian <killian@udel.edu>
+ *
+ * Copyright 2013, The University of Delaware
+ */
+#define EXTRALARGE_DATASET
+
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <math.h>
+
+/* Include polybench common header. */
+#include <polybench.h>
+
+/* Include benchmark-specific header. */
+/* Default data type is double, default size is 4000. */
+#include "correlation.h"
+#include "correlation_update.h"
+
+/* Incremental correlation: the last K rows of data arrive after the
+   others, and the kernel updates mean, stddev and symmat with them
+   only, from the state kept for the first N - K rows (see
+   correlation_update.h), in O(K M^2) instead of O(N M^2). */
+#ifndef K
+# define K (N / 40)
+#endif
+#define _PB_K POLYBENCH_LOOP_BOUND(K,k)
+
+
+/* Array initialization, and state of the first n - k rows (see
+   correlation_update.h). */
+static
+void init_array (int m,
+		 int n,
+		 int k,
+		 DATA_TYPE *float_n,
+		 DATA_TYPE POLYBENCH_2D(data,N,M,n,m),
+		 DATA_TYPE POLYBENCH_2D(comoment,M,M,m,m),
+		 DATA_TYPE POLYBENCH_1D(mu,M,m),
+		 DATA_TYPE POLYBENCH_1D(m2,M,m),
+		 DATA_TYPE POLYBENCH_1D(mu_p,M,m),
+		 DATA_TYPE POLYBENCH_1D(m2_p,M,m))
+{
+  int i, j;
+
+  *float_n = 1.2;
+
+  for (i = 0; i < n; i++)
+    for (j = 0; j < m; j++)
+      data[i][j] = ((DATA_TYPE) i*j) / m;
+
+  for (i = 0; i < m; i++)
+    {
+      for (j = 0; j < m; j++)
+	comoment[i][j] = 0.0;
+      mu[i] = m2[i] = 0.0;
+    }
+  /* data is centered in place, but only its last k rows are read
+     again. */
+  #pragma omp parallel
+  correlation_append (m, n - k, 0, data, comoment, mu, m2, mu_p, m2_p);
+}
+
+
+/* Restore the state of the first n - k rows, and receive the last k
+   rows of data. */
+static
+void receive_rows (int m,
+		   int n,
+		   int k,
+		   DATA_TYPE POLYBENCH_2D(data,N,M,n,m),
+		   DATA_TYPE POLYBENCH_2D(comoment0,M,M,m,m),
+		   DATA_TYPE POLYBENCH_1D(mu0,M,m),
+		   DATA_TYPE POLYBENCH_1D(m20,M,m),
+		   DATA_TYPE POLYBENCH_2D(rows,K,M,k,m),
+		   DATA_TYPE POLYBENCH_2D(comoment,M,M,m,m),
+		   DATA_TYPE POLYBENCH_1D(mu,M,m),
+		   DATA_TYPE POLYBENCH_1D(m2,M,m))
+{
+  int i;
+
+  for (i = 0; i < m; i++)
+    memcpy (comoment[i], comoment0[i], m * sizeof(DATA_TYPE));
+  memcpy (mu, mu0, m * sizeof(DATA_TYPE));
+  memcpy (m2, m20, m * sizeof(DATA_TYPE));
+  for (i = 0; i < k; i++)
+    memcpy (rows[i], data[n - k + i], m * sizeof(DATA_TYPE));
+}
+
+
+/* DCE code. Must scan the entire live-out data.
+   Can be used also to check the correctness of the output. */
+static
+void print_array(int m,
+		 DATA_TYPE POLYBENCH_2D(symmat,M,M,m,m))
+
+{
+  int i, j;
+
+  for (i = 0; i < m; i++)
+    for (j = 0; j < m; j++) {
+      fprintf (stderr, DATA_PRINTF_MODIFIER, symmat[i][j]);
+      if ((i * m + j) % 20 == 0) fprintf (stderr, "\n");
+    }
+  fprintf (stderr, "\n");
+}
+
+
+/* Main computational kernel. The whole function will be timed,
+   including the call and return. */
+static
+void kernel_correlation(int m, int k, long long count,
+			DATA_TYPE float_n,
+			DATA_TYPE POLYBENCH_2D(rows,K,M,k,m),
+			DATA_TYPE POLYBENCH_2D(comoment,M,M,m,m),
+			DATA_TYPE POLYBENCH_1D(mu,M,m),
+			DATA_TYPE POLYBENCH_1D(m2,M,m),
+			DATA_TYPE POLYBENCH_2D(symmat,M,M,m,m),
+			DATA_TYPE POLYBENCH_1D(mean,M,m),
+			DATA_TYPE POLYBENCH_1D(stddev,M,m))
+{
+  DATA_TYPE eps = 0.1f;
+  DATA_TYPE* mu_p = (DATA_TYPE*) polybench_alloc_data (2 * m, sizeof(DATA_TYPE));
+  DATA_TYPE* m2_p = mu_p + m;
+
+  #pragma omp parallel
+  {
+    polybench_region_begin ("kernel_correlation");
+    /* Append the new rows to the state of the count previous ones. */
+    polybench_region_begin ("append");
+    correlation_append (m, k, count, rows, comoment, mu, m2, mu_p, m2_p);
+    polybench_region_end ("append");
+
+    /* Refresh the outputs from the state. */
+    polybench_region_begin ("symmat");
+    correlation_finish (m, count + k, float_n, eps, comoment, mu, m2,
+			mean, stddev, symmat);
+    polybench_region_end ("symmat");
+    polybench_region_end ("kernel_correlation");
+  }
+  polybench_free_data (mu_p);
+}
+
+
+int main(int argc, char** argv)
+{
+  /* Retrieve problem size. */
+  int n = POLYBENCH_SIZE(N);
+  int m = POLYBENCH_SIZE(M);
+  int k = POLYBENCH_SIZE(K);
+
+  if (k > n)
+    k = n;
+
+  /* Flops and compulsory memory traffic of an update, for the GFLOP/s
+     and roofline reports. */
+  polybench_set_program_flops ((double) k * m * (m + 1) + 6.0 * k * m + 4.0 * m * m);
+  polybench_set_program_bytes (((double) k * m + 3.0 * m * m) * sizeof(DATA_TYPE));
+
+  /* Variable declaration/allocation. */
+  DATA_TYPE float_n;
+  POLYBENCH_2D_ARRAY_DECL(data,DATA_TYPE,N,M,n,m);
+  POLYBENCH_2D_ARRAY_DECL(rows,DATA_TYPE,K,M,k,m);
+  POLYBENCH_2D_ARRAY_DECL(comoment,DATA_TYPE,M,M,m,m);
+  POLYBENCH_2D_ARRAY_DECL(comoment0,DATA_TYPE,M,M,m,m);
+  POLYBENCH_1D_ARRAY_DECL(mu,DATA_TYPE,M,m);
+  POLYBENCH_1D_ARRAY_DECL(m2,DATA_TYPE,M,m);
+  POLYBENCH_1D_ARRAY_DECL(mu0,DATA_TYPE,M,m);
+  POLYBENCH_1D_ARRAY_DECL(m20,DATA_TYPE,M,m);
+  POLYBENCH_2D_ARRAY_DECL(symmat,DATA_TYPE,M,M,m,m);
+  POLYBENCH_1D_ARRAY_DECL(mean,DATA_TYPE,M,m);
+  POLYBENCH_1D_ARRAY_DECL(stddev,DATA_TYPE,M,m);
+
+  /* Initialize array(s), and the state of the previous rows (untimed). */
+  init_array (m, n, k, &float_n, POLYBENCH_ARRAY(data),
+	      POLYBENCH_ARRAY(comoment0), POLYBENCH_ARRAY(mu0),
+	      POLYBENCH_ARRAY(m20), POLYBENCH_ARRAY(mu), POLYBENCH_ARRAY(m2));
+
+  /* Run the kernel once per repetition (see polybench.h). */
+  polybench_repeat
+    {
+      receive_rows (m, n, k, POLYBENCH_ARRAY(data),
+		    POLYBENCH_ARRAY(comoment0), POLYBENCH_ARRAY(mu0),
+		    POLYBENCH_ARRAY(m20), POLYBENCH_ARRAY(rows),
+		    POLYBENCH_ARRAY(comoment), POLYBENCH_ARRAY(mu),
+		    POLYBENCH_ARRAY(m2));
+
+      /* Start timer. */
+      polybench_start_instruments;
+      /* Run kernel. */
+      kernel_correlation (m, k, n - k, float_n,
+			  POLYBENCH_ARRAY(rows),
+			  POLYBENCH_ARRAY(comoment),
+			  POLYBENCH_ARRAY(mu),
+			  POLYBENCH_ARRAY(m2),
+			  POLYBENCH_ARRAY(symmat),
+			  POLYBENCH_ARRAY(mean),
+			  POLYBENCH_ARRAY(stddev));
+
+      /* Stop timer. */
+      polybench_stop_instruments;
+    }
+  /* Print timer. */
+  polybench_print_instruments;
+
+  /* Prevent dead-code elimination. All live-out data must be printed
+     by the function call in argument. */
+  polybench_prevent_dce(print_array(m, POLYBENCH_ARRAY(symmat)));
+
+  /* Check the output, as selected with POLYBENCH_VERIFY. */
+  polybench_verify_2d (symmat, m, m);
+
+  /* Be clean. */
+  POLYBENCH_FREE_ARRAY(data);
+  POLYBENCH_FREE_ARRAY(rows);
+  POLYBENCH_FREE_ARRAY(comoment);
+  POLYBENCH_FREE_ARRAY(comoment0);
+  POLYBENCH_FREE_ARRAY(mu);
+  POLYBENCH_FREE_ARRAY(m2);
+  POLYBENCH_FREE_ARRAY(mu0);
+  POLYBENCH_FREE_ARRAY(m20);
+  POLYBENCH_FREE_ARRAY(symmat);
+  POLYBENCH_FREE_ARRAY(mean);
+  POLYBENCH_FREE_ARRAY(stddev);
+
+  return 0;
+}
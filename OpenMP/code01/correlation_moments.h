@@ -0,0 +1,171 @@
+/**
+ * correlation_moments.h: single-pass mean and standard deviation of the
+ * column vectors for the correlation kernel (correlation_v2 and later).
+ *
+ * The rows of data are streamed once, in row-major order, updating the
+ * running mean and sum of squared deviations of every column (Welford).
+ * Partial moments of disjoint sets of rows are merged with the parallel
+ * variance formula (Chan et al.).
+ */
+#ifndef CORRELATION_MOMENTS_H
+# define CORRELATION_MOMENTS_H
+
+# ifdef _OPENMP
+#  include <omp.h>
+# endif
+
+
+/* Add row x to the moments (mu, m2) of count - 1 rows. */
+static inline
+void correlation_moments_row(int m, long count, const DATA_TYPE* x,
+			     DATA_TYPE* mu, DATA_TYPE* m2)
+{
+  DATA_TYPE inv = (DATA_TYPE) 1.0 / count;
+  int j;
+
+  #pragma omp simd
+  for (j = 0; j < m; j++)
+    {
+      DATA_TYPE delta = x[j] - mu[j];
+      mu[j] += delta * inv;
+      m2[j] += delta * (x[j] - mu[j]);
+    }
+}
+
+
+/* Merge the moments of nb rows (mub, m2b) into those of na rows
+   (mua, m2a). */
+static inline
+void correlation_moments_merge(int m, long na, DATA_TYPE* mua,
+			       DATA_TYPE* m2a, long nb,
+			       const DATA_TYPE* mub, const DATA_TYPE* m2b)
+{
+  DATA_TYPE wb, wab;
+  int j;
+
+  if (nb == 0)
+    return;
+  if (na == 0)
+    {
+      memcpy (mua, mub, m * sizeof(DATA_TYPE));
+      memcpy (m2a, m2b, m * sizeof(DATA_TYPE));
+      return;
+    }
+  wb = (DATA_TYPE) nb / (na + nb);
+  wab = (DATA_TYPE) na * nb / (na + nb);
+  #pragma omp simd
+  for (j = 0; j < m; j++)
+    {
+      DATA_TYPE delta = mub[j] - mua[j];
+      mua[j] += delta * wb;
+      m2a[j] += m2b[j] + delta * delta * wab;
+    }
+}
+
+
+/* The mean and standard deviation of the kernel, from the moments of
+   the n rows (mean and stddev may be mu and m2). PolyBench divides the
+   sums by float_n rather than n: the sum of the squared deviations from
+   mean is m2 + n (mu - mean)^2. */
+static inline
+void correlation_moments_finish(int m, long n, DATA_TYPE float_n,
+				DATA_TYPE eps, const DATA_TYPE* mu,
+				const DATA_TYPE* m2, DATA_TYPE* mean,
+				DATA_TYPE* stddev)
+{
+  int j;
+
+  for (j = 0; j < m; j++)
+    {
+      DATA_TYPE u = mu[j], s = m2[j], d;
+      mean[j] = u * n / float_n;
+      d = u - mean[j];
+      stddev[j] = sqrt ((s + n * d * d) / float_n);
+      /* Near-zero standard deviations would cause a zero-divide. */
+      stddev[j] = stddev[j] <= eps ? 1.0 : stddev[j];
+    }
+}
+
+
+/* Moments (mu, m2) of the columns of data, shared by the team. Must be
+   called by all the threads of a parallel region: each thread streams
+   its rows into its own partial moments, and the partials are merged
+   by a binary tree of log2(threads) steps. */
+static
+void correlation_moments_rows(int m, int n,
+			      DATA_TYPE POLYBENCH_2D(data,N,M,n,m),
+			      DATA_TYPE* mu, DATA_TYPE* m2)
+{
+  /* Partial rows padded to a cache line, to avoid false sharing. */
+  int ld = (_PB_M + 15) & ~15;
+  int tid = 0, nb_threads = 1, stride, i, j;
+  DATA_TYPE* partials;
+  long* counts;
+  DATA_TYPE* pmu;
+  DATA_TYPE* pm2;
+  long count = 0;
+
+#ifdef _OPENMP
+  tid = omp_get_thread_num ();
+  nb_threads = omp_get_num_threads ();
+#endif
+  #pragma omp single copyprivate (partials, counts)
+  {
+    partials = (DATA_TYPE*)
+      malloc (2 * (size_t) nb_threads * ld * sizeof(DATA_TYPE));
+    counts = (long*) malloc (nb_threads * sizeof(long));
+    if (partials == NULL || counts == NULL)
+      {
+	fprintf (stderr, "correlation: cannot allocate the moments\n");
+	exit (1);
+      }
+  }
+  pmu = partials + 2 * (size_t) tid * ld;
+  pm2 = pmu + ld;
+  for (j = 0; j < _PB_M; j++)
+    pmu[j] = pm2[j] = 0;
+
+  #pragma omp for POLYBENCH_SCHEDULE(static) nowait
+  for (i = 0; i < _PB_N; i++)
+    correlation_moments_row (_PB_M, ++count, data[i], pmu, pm2);
+  counts[tid] = count;
+  #pragma omp barrier
+
+  for (stride = 1; stride < nb_threads; stride *= 2)
+    {
+      if (tid % (2 * stride) == 0 && tid + stride < nb_threads)
+	{
+	  correlation_moments_merge (_PB_M, counts[tid], pmu, pm2,
+				     counts[tid + stride],
+				     pmu + 2 * stride * ld,
+				     pm2 + 2 * stride * ld);
+	  counts[tid] += counts[tid + stride];
+	}
+      #pragma omp barrier
+    }
+
+  #pragma omp single
+  {
+    memcpy (mu, partials, _PB_M * sizeof(DATA_TYPE));
+    memcpy (m2, partials + ld, _PB_M * sizeof(DATA_TYPE));
+    free (partials);
+    free (counts);
+  }
+}
+
+
+/* mean and stddev of the columns of data. Must be called by all the
+   threads of a parallel region. */
+static inline
+void correlation_moments(int m, int n, DATA_TYPE float_n, DATA_TYPE eps,
+			 DATA_TYPE POLYBENCH_2D(data,N,M,n,m),
+			 DATA_TYPE POLYBENCH_1D(mean,M,m),
+			 DATA_TYPE POLYBENCH_1D(stddev,M,m))
+{
+  correlation_moments_rows (m, n, data, mean, stddev);
+  #pragma omp single
+  correlation_moments_finish (_PB_M, _PB_N, float_n, eps, mean, stddev,
+			      mean, stddev);
+}
+
+#endif /* !CORRELATION_MOMENTS_H */
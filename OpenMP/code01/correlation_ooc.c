@@ -0,0 +1,336 @@
+/* POLYBENCH/GPU-OPENMP
+ *
+ * This file is a part of the Polybench/GPU-OpenMP suite
+ *
+ * Contact:
+ * William Killian <killian@udel.edu>
+ *
+ * Copyright 2013, The University of Delaware
+ */
+#define EXTRALARGE_DATASET
+/* Out-of-core correlation: the data matrix is never allocated, only
+   symmat and two panels of rows, so the sizes are set at run time and
+   N is only bound by the input file. */
+#ifndef POLYBENCH_USE_C99_PROTO
+# define POLYBENCH_USE_C99_PROTO
+#endif
+
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <aio.h>
+#include <sys/stat.h>
+
+/* Include polybench common header. */
+#include <polybench.h>
+
+/* Include benchmark-specific header. */
+/* Default data type is double, default size is 4000. */
+#include "correlation.h"
+#include "correlation_update.h"
+
+/* The data is read from the binary file CORRELATION_INPUT, N rows of M
+   DATA_TYPE in row-major order (N is taken from the file size), or, by
+   default, from a temporary file holding the PolyBench input. It is
+   streamed by panels of CORRELATION_PANEL rows (default: 1024), with
+   the read of the next panel overlapped with the computation on the
+   current one. symmat is also written to CORRELATION_OUTPUT, in the
+   same format: every row depends on all the data, so that the rows are
+   written in parallel once the last panel is consumed and symmat is
+   finished. */
+#ifndef OOC_PANEL
+# define OOC_PANEL 1024
+#endif
+
+
+/* Double-buffered asynchronous reads of the panels. */
+struct ooc_reader
+{
+  int fd;
+  int m;
+  long long n;
+  int rows;
+  DATA_TYPE* buf[2];
+  struct aiocb cb[2];
+};
+
+
+/* Write the PolyBench input to fd. */
+static
+void init_file(int m, int n, DATA_TYPE *float_n, int fd)
+{
+  DATA_TYPE* row = (DATA_TYPE*) polybench_alloc_data (m, sizeof(DATA_TYPE));
+  ssize_t len = m * sizeof(DATA_TYPE);
+  int i, j;
+
+  *float_n = 1.2;
+
+  for (i = 0; i < n; i++)
+    {
+      for (j = 0; j < m; j++)
+	row[j] = ((DATA_TYPE) i*j) / m;
+      if (write (fd, row, len) != len)
+	{
+	  fprintf (stderr, "correlation: cannot write the input: %s\n",
+		   strerror (errno));
+	  exit (1);
+	}
+    }
+  polybench_free_data (row);
+}
+
+
+/* DCE code. Must scan the entire live-out data.
+   Can be used also to check the correctness of the output. */
+static
+void print_array(int m,
+		 DATA_TYPE POLYBENCH_2D(symmat,M,M,m,m))
+
+{
+  int i, j;
+
+  for (i = 0; i < m; i++)
+    for (j = 0; j < m; j++) {
+      fprintf (stderr, DATA_PRINTF_MODIFIER, symmat[i][j]);
+      if ((i * m + j) % 20 == 0) fprintf (stderr, "\n");
+    }
+  fprintf (stderr, "\n");
+}
+
+
+/* Start reading panel p. */
+static
+void ooc_read_start(struct ooc_reader* r, long long p)
+{
+  struct aiocb* cb = &r->cb[p % 2];
+  long long first = p * r->rows;
+  long long rows = r->n - first < r->rows ? r->n - first : r->rows;
+
+  memset (cb, 0, sizeof(*cb));
+  cb->aio_fildes = r->fd;
+  cb->aio_buf = r->buf[p % 2];
+  cb->aio_nbytes = rows * r->m * sizeof(DATA_TYPE);
+  cb->aio_offset = first * r->m * sizeof(DATA_TYPE);
+  if (aio_read (cb))
+    {
+      fprintf (stderr, "correlation: cannot read the input: %s\n",
+	       strerror (errno));
+      exit (1);
+    }
+}
+
+
+/* Wait for panel p and return its number of rows. */
+static
+int ooc_read_wait(struct ooc_reader* r, long long p)
+{
+  struct aiocb* cb = &r->cb[p % 2];
+  const struct aiocb* list[1] = { cb };
+  char* buf = (char*) r->buf[p % 2];
+  size_t done;
+  ssize_t ret;
+  int rows, i;
+
+  while (aio_error (cb) == EINPROGRESS)
+    aio_suspend (list, 1, NULL);
+  ret = aio_return (cb);
+  /* Finish short reads synchronously. */
+  for (done = ret > 0 ? ret : 0; ret >= 0 && done < cb->aio_nbytes;
+       done += ret)
+    if ((ret = pread (r->fd, buf + done, cb->aio_nbytes - done,
+		      cb->aio_offset + done)) <= 0)
+      break;
+  if (ret < 0 || done < cb->aio_nbytes)
+    {
+      fprintf (stderr, "correlation: cannot read the input: %s\n",
+	       ret < 0 ? strerror (errno) : "unexpected end of file");
+      exit (1);
+    }
+  rows = cb->aio_nbytes / (r->m * sizeof(DATA_TYPE));
+  /* Spread the rows to the padded leading dimension, from the last. */
+  if (POLYBENCH_PADDING_FACTOR)
+    for (i = rows - 1; i > 0; i--)
+      memmove (r->buf[p % 2] + (size_t) i * (r->m + POLYBENCH_PADDING_FACTOR),
+	       r->buf[p % 2] + (size_t) i * r->m, r->m * sizeof(DATA_TYPE));
+  /* Each panel is read once: keep it out of the page cache. */
+  posix_fadvise (r->fd, cb->aio_offset, cb->aio_nbytes, POSIX_FADV_DONTNEED);
+  return rows;
+}
+
+
+/* Main computational kernel. The whole function will be timed,
+   including the call and return. */
+static
+void kernel_correlation(int m, long long n,
+			DATA_TYPE float_n,
+			struct ooc_reader* r, int out,
+			DATA_TYPE POLYBENCH_2D(symmat,M,M,m,m),
+			DATA_TYPE POLYBENCH_1D(mean,M,m),
+			DATA_TYPE POLYBENCH_1D(stddev,M,m))
+{
+  DATA_TYPE eps = 0.1f;
+  DATA_TYPE* mu = (DATA_TYPE*) polybench_alloc_data (4 * m, sizeof(DATA_TYPE));
+  DATA_TYPE* m2 = mu + m;
+  DATA_TYPE* mu_p = m2 + m;
+  DATA_TYPE* m2_p = mu_p + m;
+  long long nb_panels = (n + r->rows - 1) / r->rows, p, count = 0;
+  int rows, j, j1, j2;
+
+  /* The co-moments accumulate in the upper triangle of symmat (see
+     correlation_update.h). */
+  #pragma omp parallel for private (j2) POLYBENCH_SCHEDULE_DEFAULT
+  for (j1 = 0; j1 < _PB_M; j1++)
+    for (j2 = 0; j2 < _PB_M; j2++)
+      symmat[j1][j2] = 0.0;
+  for (j = 0; j < _PB_M; j++)
+    mu[j] = m2[j] = 0.0;
+
+  ooc_read_start (r, 0);
+  for (p = 0; p < nb_panels; p++)
+    {
+      DATA_TYPE (*panel)[m + POLYBENCH_PADDING_FACTOR];
+
+      rows = ooc_read_wait (r, p);
+      if (p + 1 < nb_panels)
+	ooc_read_start (r, p + 1);
+      panel = (DATA_TYPE (*)[m + POLYBENCH_PADDING_FACTOR]) r->buf[p % 2];
+
+      #pragma omp parallel
+      {
+	polybench_region_begin ("panel");
+	correlation_append (m, rows, count, panel, symmat, mu, m2, mu_p, m2_p);
+	polybench_region_end ("panel");
+      }
+      count += rows;
+    }
+
+  #pragma omp parallel
+  {
+    polybench_region_begin ("symmat");
+    correlation_finish (m, n, float_n, eps, symmat, mu, m2, mean, stddev,
+			symmat);
+    /* Write the rows of the finished symmat, in parallel. */
+    #pragma omp for POLYBENCH_SCHEDULE_DEFAULT
+    for (j1 = 0; j1 < _PB_M; j1++)
+      if (out >= 0
+	  && pwrite (out, symmat[j1], m * sizeof(DATA_TYPE),
+		     (off_t) j1 * m * sizeof(DATA_TYPE))
+	  != (ssize_t) (m * sizeof(DATA_TYPE)))
+	{
+	  fprintf (stderr, "correlation: cannot write the output: %s\n",
+		   strerror (errno));
+	  exit (1);
+	}
+    polybench_region_end ("symmat");
+  }
+  polybench_free_data (mu);
+}
+
+
+int main(int argc, char** argv)
+{
+  /* Retrieve problem size. */
+  long long n = POLYBENCH_SIZE(N);
+  int m = POLYBENCH_SIZE(M);
+  const char* input = getenv ("CORRELATION_INPUT");
+  const char* output = getenv ("CORRELATION_OUTPUT");
+  const char* panel = getenv ("CORRELATION_PANEL");
+  struct ooc_reader r;
+  int out = -1;
+
+  /* Variable declaration/allocation. */
+  DATA_TYPE float_n = 1.2;
+  POLYBENCH_2D_ARRAY_DECL(symmat,DATA_TYPE,M,M,m,m);
+  POLYBENCH_1D_ARRAY_DECL(mean,DATA_TYPE,M,m);
+  POLYBENCH_1D_ARRAY_DECL(stddev,DATA_TYPE,M,m);
+
+  /* Open the input, or write the PolyBench one to a temporary file. */
+  if (input)
+    {
+      struct stat st;
+      if ((r.fd = open (input, O_RDONLY)) < 0 || fstat (r.fd, &st))
+	{
+	  fprintf (stderr, "correlation: cannot open %s: %s\n", input,
+		   strerror (errno));
+	  return 1;
+	}
+      n = st.st_size / (m * sizeof(DATA_TYPE));
+      if ((off_t) (n * m * sizeof(DATA_TYPE)) != st.st_size)
+	fprintf (stderr, "correlation: %s is not a multiple of %d columns, "
+		 "reading %lld rows\n", input, m, n);
+    }
+  else
+    {
+      char path[4096];
+      snprintf (path, sizeof(path), "%s/correlation_ooc.XXXXXX",
+		getenv ("TMPDIR") ? getenv ("TMPDIR") : "/tmp");
+      if ((r.fd = mkstemp (path)) < 0)
+	{
+	  fprintf (stderr, "correlation: cannot create %s: %s\n", path,
+		   strerror (errno));
+	  return 1;
+	}
+      unlink (path);
+      init_file (m, n, &float_n, r.fd);
+    }
+  if (output && (out = open (output, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+    {
+      fprintf (stderr, "correlation: cannot open %s: %s\n", output,
+	       strerror (errno));
+      return 1;
+    }
+  posix_fadvise (r.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  r.m = m;
+  r.n = n;
+  r.rows = panel && atoi (panel) > 0 ? atoi (panel) : OOC_PANEL;
+  r.buf[0] = (DATA_TYPE*) polybench_alloc_data
+    ((unsigned long long) r.rows * (m + POLYBENCH_PADDING_FACTOR),
+     sizeof(DATA_TYPE));
+  r.buf[1] = (DATA_TYPE*) polybench_alloc_data
+    ((unsigned long long) r.rows * (m + POLYBENCH_PADDING_FACTOR),
+     sizeof(DATA_TYPE));
+
+  /* Flops and compulsory memory traffic, for the GFLOP/s and roofline
+     reports. */
+  polybench_set_program_flops ((double) n * m * (m - 1) + 6.0 * n * m + 4.0 * m);
+  polybench_set_program_bytes (((double) n * m + (double) m * m) * sizeof(DATA_TYPE));
+
+  /* Run the kernel once per repetition (see polybench.h). */
+  polybench_repeat
+    {
+      /* Start timer. */
+      polybench_start_instruments;
+      /* Run kernel. */
+      kernel_correlation (m, n, float_n, &r, out,
+			  POLYBENCH_ARRAY(symmat),
+			  POLYBENCH_ARRAY(mean),
+			  POLYBENCH_ARRAY(stddev));
+
+      /* Stop timer. */
+      polybench_stop_instruments;
+    }
+  /* Print timer. */
+  polybench_print_instruments;
+
+  /* Prevent dead-code elimination. All live-out data must be printed
+     by the function call in argument. */
+  polybench_prevent_dce(print_array(m, POLYBENCH_ARRAY(symmat)));
+
+  /* Check the output, as selected with POLYBENCH_VERIFY. */
+  polybench_verify_2d (symmat, m, m);
+
+  /* Be clean. */
+  polybench_free_data (r.buf[0]);
+  polybench_free_data (r.buf[1]);
+  POLYBENCH_FREE_ARRAY(symmat);
+  POLYBENCH_FREE_ARRAY(mean);
+  POLYBENCH_FREE_ARRAY(stddev);
+  close (r.fd);
+  if (out >= 0)
+    close (out);
+
+  return 0;
+}
@@ -0,0 +1,432 @@
+/* POLYBENCH/GPU-OPENMP
+ *
+ * This file is a part of the Polybench/GPU-OpenMP suite
+ *
+ * Contact:
+ * William Killian <killian@udel.edu>
+ *
+ * Copyright 2013, The University of Delaware
+ */
+#define EXTRALARGE_DATASET
+
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+
+/* Include polybench common header. */
+#include <polybench.h>
+
+/* Include benchmark-specific header. */
+/* Default data type is double, default size is 4000. */
+#include "correlation.h"
+#include "correlation_moments.h"
+#include "correlation_syrk.h"
+
+/* Sparse output: symmat is never stored. As the tiles of its upper
+   triangle complete, the pairs j1 < j2 with |symmat[j1][j2]| at least
+   CORRELATION_THRESHOLD (default: 0.5) are appended to
+   CORRELATION_OUTPUT as COO records (struct sparse_entry), in no
+   particular order. With CORRELATION_TOPK=k, only the k strongest of
+   these pairs are kept for each column, and written column by column
+   at the end, strongest first: a pair then appears once for each of its
+   columns that keeps it. With POLYBENCH_VERIFY, the records are also
+   scattered into a dense M x M matrix, zero elsewhere, which is checked
+   as symmat (this needs the memory of symmat: meant for small M). With
+   CORRELATION_TOPK, the values kept for each column, strongest first,
+   are checked instead as an M x k matrix: the partners of nearly equal
+   correlations depend on the rounding, their values do not. */
+#ifndef SPARSE_THRESHOLD
+# define SPARSE_THRESHOLD 0.5
+#endif
+
+/* Records buffered by each thread before a write. */
+#ifndef SPARSE_BUFFER
+# define SPARSE_BUFFER 4096
+#endif
+
+
+/* One record of the output. */
+struct sparse_entry
+{
+  int row;
+  int col;
+  DATA_TYPE value;
+};
+
+
+/* Output of the kernel, shared by the threads. */
+struct sparse_output
+{
+  int fd;
+  off_t offset;
+  long long nnz;
+  DATA_TYPE threshold;
+  int k;
+  /* With POLYBENCH_VERIFY: dense[row][col] = value of each record, or
+     with k > 0, dense[col][e] = value of its e-th strongest partner. */
+  DATA_TYPE* dense;
+  int m;
+  /* With k > 0: the partners and values of each column, in a min-heap
+     of at most k entries on |value|. */
+  int* fill;
+  struct sparse_entry* heaps;
+#ifdef _OPENMP
+  omp_lock_t* locks;
+#endif
+};
+
+
+/* Array initialization. */
+static
+void init_array (int m,
+		 int n,
+		 DATA_TYPE *float_n,
+		 DATA_TYPE POLYBENCH_2D(data,N,M,n,m))
+{
+  int i, j;
+
+  *float_n = 1.2;
+
+  for (i = 0; i < n; i++)
+    for (j = 0; j < m; j++)
+      data[i][j] = ((DATA_TYPE) i*j) / m;
+}
+
+
+/* DCE code. Must scan the entire live-out data.
+   Can be used also to check the correctness of the output. */
+static
+void print_array(struct sparse_output* out)
+{
+  fprintf (stderr, "%lld pairs\n", out->nnz);
+}
+
+
+/* Write the count records of buf at the end of the output. */
+static
+void sparse_flush(struct sparse_output* out, struct sparse_entry* buf,
+		  int count)
+{
+  ssize_t len = count * sizeof(struct sparse_entry);
+  off_t offset;
+
+  #pragma omp atomic capture
+  { offset = out->offset; out->offset += len; }
+  #pragma omp atomic
+  out->nnz += count;
+  if (out->dense && ! out->k)
+    {
+      int e;
+      /* Each record has its own element. */
+      for (e = 0; e < count; e++)
+	out->dense[(size_t) buf[e].row * out->m + buf[e].col] = buf[e].value;
+    }
+  if (out->fd >= 0 && pwrite (out->fd, buf, len, offset) != len)
+    {
+      fprintf (stderr, "correlation: cannot write the output: %s\n",
+	       strerror (errno));
+      exit (1);
+    }
+}
+
+
+/* Append a record to the buffer of the thread. */
+static inline
+void sparse_emit(struct sparse_output* out, struct sparse_entry* buf,
+		 int* count, int row, int col, DATA_TYPE value)
+{
+  buf[*count].row = row;
+  buf[*count].col = col;
+  buf[*count].value = value;
+  if (++*count == SPARSE_BUFFER)
+    {
+      sparse_flush (out, buf, *count);
+      *count = 0;
+    }
+}
+
+
+/* Offer partner p of column j to its heap. The caller holds the lock
+   of the column. */
+static
+void sparse_topk_insert(struct sparse_output* out, int j, int p,
+			DATA_TYPE value)
+{
+  struct sparse_entry* h = out->heaps + (size_t) j * out->k;
+  struct sparse_entry e;
+  int i = out->fill[j], c;
+
+  e.row = j;
+  e.col = p;
+  e.value = value;
+  if (i < out->k)
+    {
+      /* Sift up. */
+      out->fill[j]++;
+      for (; i > 0 && fabs (h[(i - 1) / 2].value) > fabs (value);
+	   i = (i - 1) / 2)
+	h[i] = h[(i - 1) / 2];
+      h[i] = e;
+      return;
+    }
+  if (fabs (value) <= fabs (h[0].value))
+    return;
+  /* Replace the weakest, and sift down. */
+  for (i = 0; (c = 2 * i + 1) < out->k; i = c)
+    {
+      if (c + 1 < out->k && fabs (h[c + 1].value) < fabs (h[c].value))
+	c++;
+      if (fabs (h[c].value) >= fabs (value))
+	break;
+      h[i] = h[c];
+    }
+  h[i] = e;
+}
+
+
+static
+int sparse_compare(const void* a, const void* b)
+{
+  DATA_TYPE x = fabs (((const struct sparse_entry*) a)->value);
+  DATA_TYPE y = fabs (((const struct sparse_entry*) b)->value);
+
+  return x < y ? 1 : x > y ? -1 : 0;
+}
+
+
+/* Main computational kernel. The whole function will be timed,
+   including the call and return. */
+static
+void kernel_correlation(int m, int n,
+			DATA_TYPE float_n,
+			DATA_TYPE POLYBENCH_2D(data,N,M,n,m),
+			struct sparse_output* out,
+			DATA_TYPE POLYBENCH_1D(mean,M,m),
+			DATA_TYPE POLYBENCH_1D(stddev,M,m))
+{
+  int i, j;
+
+  DATA_TYPE eps = 0.1f;
+  double sqrt_float_n = sqrt(float_n);
+  int nt = (_PB_M + SYRK_TILE - 1) / SYRK_TILE;
+
+  out->offset = 0;
+  out->nnz = 0;
+  if (out->k)
+    memset (out->fill, 0, m * sizeof(int));
+
+  #pragma omp parallel
+  {
+    DATA_TYPE a[SYRK_DEPTH][SYRK_TILE] __attribute__ ((aligned (64)));
+    DATA_TYPE b[SYRK_DEPTH][SYRK_TILE] __attribute__ ((aligned (64)));
+    DATA_TYPE c[SYRK_TILE][SYRK_TILE] __attribute__ ((aligned (64)));
+    struct sparse_entry* buf = (struct sparse_entry*)
+      malloc (SPARSE_BUFFER * sizeof(struct sparse_entry));
+    int count = 0;
+    long t;
+
+    if (buf == NULL)
+      {
+	fprintf (stderr, "correlation: cannot allocate the output buffer\n");
+	exit (1);
+      }
+    polybench_region_begin ("kernel_correlation");
+    /* Determine mean and standard deviations of column vectors of
+       data matrix, in one pass over its rows (see
+       correlation_moments.h). */
+    polybench_region_begin ("moments");
+    correlation_moments (m, n, float_n, eps, data, mean, stddev);
+    polybench_region_end ("moments");
+
+    /* Center and reduce the column vectors, in a second pass. */
+    polybench_region_begin ("center");
+    #pragma omp for private (j) POLYBENCH_SCHEDULE_DEFAULT
+    for (i = 0; i < _PB_N; i++)
+      #pragma omp simd
+      for (j = 0; j < _PB_M; j++)
+	data[i][j] = (data[i][j] - mean[j]) / (sqrt_float_n * stddev[j]);
+    polybench_region_end ("center");
+
+    /* Calculate the tiles of the upper triangle of the correlation
+       matrix (see correlation_syrk.h), and keep the strong pairs. The
+       cost of a tile grows with its number of pairs. */
+    polybench_region_begin ("symmat");
+    #pragma omp for POLYBENCH_SCHEDULE(dynamic,4)
+    for (t = 0; t < (long) nt * (nt + 1) / 2; t++)
+      {
+	int t1, t2, j1, j2, x, y, w1, w2;
+
+	correlation_syrk_coords (nt, t, &t1, &t2);
+	correlation_syrk_tile (m, n, t1, t2, data, a, b, c);
+	w1 = _PB_M - t1 * SYRK_TILE < SYRK_TILE ? _PB_M - t1 * SYRK_TILE : SYRK_TILE;
+	w2 = _PB_M - t2 * SYRK_TILE < SYRK_TILE ? _PB_M - t2 * SYRK_TILE : SYRK_TILE;
+	if (! out->k)
+	  {
+	    for (x = 0; x < w1; x++)
+	      for (y = t1 == t2 ? x + 1 : 0; y < w2; y++)
+		if (fabs (c[x][y]) >= out->threshold)
+		  sparse_emit (out, buf, &count, t1 * SYRK_TILE + x,
+			       t2 * SYRK_TILE + y, c[x][y]);
+	    continue;
+	  }
+	/* Both columns of a pair are offered the other one. */
+	for (x = 0; x < w1; x++)
+	  {
+	    j1 = t1 * SYRK_TILE + x;
+#ifdef _OPENMP
+	    omp_set_lock (&out->locks[j1]);
+#endif
+	    for (y = t1 == t2 ? x + 1 : 0; y < w2; y++)
+	      if (fabs (c[x][y]) >= out->threshold)
+		sparse_topk_insert (out, j1, t2 * SYRK_TILE + y, c[x][y]);
+#ifdef _OPENMP
+	    omp_unset_lock (&out->locks[j1]);
+#endif
+	  }
+	for (y = 0; y < w2; y++)
+	  {
+	    j2 = t2 * SYRK_TILE + y;
+#ifdef _OPENMP
+	    omp_set_lock (&out->locks[j2]);
+#endif
+	    for (x = 0; x < (t1 == t2 ? y : w1); x++)
+	      if (fabs (c[x][y]) >= out->threshold)
+		sparse_topk_insert (out, j2, t1 * SYRK_TILE + x, c[x][y]);
+#ifdef _OPENMP
+	    omp_unset_lock (&out->locks[j2]);
+#endif
+	  }
+      }
+
+    /* Write the partners of each column, strongest first. */
+    if (out->k)
+      {
+	#pragma omp for POLYBENCH_SCHEDULE_DEFAULT
+	for (j = 0; j < _PB_M; j++)
+	  {
+	    struct sparse_entry* h = out->heaps + (size_t) j * out->k;
+	    int e;
+
+	    qsort (h, out->fill[j], sizeof(struct sparse_entry), sparse_compare);
+	    for (e = 0; e < out->fill[j]; e++)
+	      {
+		if (out->dense)
+		  out->dense[(size_t) j * out->k + e] = h[e].value;
+		sparse_emit (out, buf, &count, h[e].row, h[e].col, h[e].value);
+	      }
+	  }
+      }
+    if (count)
+      sparse_flush (out, buf, count);
+    free (buf);
+    polybench_region_end ("symmat");
+    polybench_region_end ("kernel_correlation");
+  }
+}
+
+int main(int argc, char** argv)
+{
+  /* Retrieve problem size. */
+  int n = POLYBENCH_SIZE(N);
+  int m = POLYBENCH_SIZE(M);
+  const char* output = getenv ("CORRELATION_OUTPUT");
+  const char* threshold = getenv ("CORRELATION_THRESHOLD");
+  const char* topk = getenv ("CORRELATION_TOPK");
+  struct sparse_output out;
+  int j;
+
+  /* Flops and compulsory memory traffic, without the output, for the
+     GFLOP/s and roofline reports. */
+  polybench_set_program_flops ((double) n * m * (m - 1) + 6.0 * n * m + 4.0 * m);
+  polybench_set_program_bytes ((2.0 * n * m) * sizeof(DATA_TYPE));
+
+  /* Variable declaration/allocation. */
+  DATA_TYPE float_n;
+  POLYBENCH_2D_ARRAY_DECL(data,DATA_TYPE,N,M,n,m);
+  POLYBENCH_1D_ARRAY_DECL(mean,DATA_TYPE,M,m);
+  POLYBENCH_1D_ARRAY_DECL(stddev,DATA_TYPE,M,m);
+
+  out.fd = -1;
+  if (output && (out.fd = open (output, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+    {
+      fprintf (stderr, "correlation: cannot open %s: %s\n", output,
+	       strerror (errno));
+      return 1;
+    }
+  out.threshold = threshold ? atof (threshold) : SPARSE_THRESHOLD;
+  out.k = topk && atoi (topk) > 0 ? atoi (topk) : 0;
+  out.fill = NULL;
+  out.heaps = NULL;
+  out.m = m;
+  out.dense = NULL;
+  if (getenv ("POLYBENCH_VERIFY"))
+    out.dense = (DATA_TYPE*) polybench_alloc_data
+      ((unsigned long long) m * (out.k ? out.k : m), sizeof(DATA_TYPE));
+  if (out.k)
+    {
+      out.fill = (int*) polybench_alloc_data (m, sizeof(int));
+      out.heaps = (struct sparse_entry*) polybench_alloc_data
+	((unsigned long long) m * out.k, sizeof(struct sparse_entry));
+#ifdef _OPENMP
+      out.locks = (omp_lock_t*) polybench_alloc_data (m, sizeof(omp_lock_t));
+      for (j = 0; j < m; j++)
+	omp_init_lock (&out.locks[j]);
+#endif
+    }
+
+  /* Run the kernel once per repetition (see polybench.h). */
+  polybench_repeat
+    {
+      /* Initialize array(s). */
+      init_array (m, n, &float_n, POLYBENCH_ARRAY(data));
+      if (out.dense)
+	memset (out.dense, 0, (size_t) m * (out.k ? out.k : m) * sizeof(DATA_TYPE));
+
+      /* Start timer. */
+      polybench_start_instruments;
+      /* Run kernel. */
+      kernel_correlation (m, n, float_n,
+			  POLYBENCH_ARRAY(data),
+			  &out,
+			  POLYBENCH_ARRAY(mean),
+			  POLYBENCH_ARRAY(stddev));
+
+      /* Stop timer. */
+      polybench_stop_instruments;
+    }
+  /* Print timer. */
+  polybench_print_instruments;
+
+  /* Prevent dead-code elimination. All live-out data must be printed
+     by the function call in argument. */
+  polybench_prevent_dce(print_array(&out));
+
+  /* Check the output, as selected with POLYBENCH_VERIFY. */
+  if (out.dense && out.k)
+    polybench_verify ("topk", out.dense, sizeof(DATA_TYPE), m, out.k, out.k);
+  else if (out.dense)
+    polybench_verify ("symmat", out.dense, sizeof(DATA_TYPE), m, m, m);
+
+  /* Be clean. */
+  POLYBENCH_FREE_ARRAY(data);
+  POLYBENCH_FREE_ARRAY(mean);
+  POLYBENCH_FREE_ARRAY(stddev);
+  if (out.k)
+    {
+#ifdef _OPENMP
+      for (j = 0; j < m; j++)
+	omp_destroy_lock (&out.locks[j]);
+      polybench_free_data (out.locks);
+#endif
+      polybench_free_data (out.fill);
+      polybench_free_data (out.heaps);
+    }
+  polybench_free_data (out.dense);
+  if (out.fd >= 0)
+    close (out.fd);
+
+  return 0;
+}
@@ -0,0 +1,177 @@
+/**
+ * correlation_syrk.h: blocked symmetric rank-k update for the
+ * correlation kernel (correlation_v2 and later).
+ *
+ * symmat = data' * data, over the centered and reduced data: only the
+ * tiles of the upper triangle are computed, and mirrored.
+ */
+#ifndef CORRELATION_SYRK_H
+# define CORRELATION_SYRK_H
+
+/* Tile of symmat (columns of data), in elements. */
+# ifndef SYRK_TILE
+#  define SYRK_TILE 64
+# endif
+
+/* Rows of data packed at a time: with the default sizes, the two
+   packed panels (2 x 256 x 64 floats) stay in L2. */
+# ifndef SYRK_DEPTH
+#  define SYRK_DEPTH 256
+# endif
+
+/* Register block of the micro-kernel, SYRK_MR x SYRK_NR accumulators.
+   SYRK_TILE must be a multiple of both. */
+# define SYRK_MR 4
+# define SYRK_NR 8
+
+
+/* Copy rows i0..i0+kb-1 of columns j0..j0+SYRK_TILE-1 of data to a
+   contiguous panel, padded with zeros past the last column. */
+static inline
+void correlation_syrk_pack(int m, int n, int i0, int kb, int j0,
+			   DATA_TYPE POLYBENCH_2D(data,N,M,n,m),
+			   DATA_TYPE panel[SYRK_DEPTH][SYRK_TILE])
+{
+  int i, j, w = _PB_M - j0 < SYRK_TILE ? _PB_M - j0 : SYRK_TILE;
+
+  for (i = 0; i < kb; i++)
+    {
+      for (j = 0; j < w; j++)
+	panel[i][j] = data[i0 + i][j0 + j];
+      for (; j < SYRK_TILE; j++)
+	panel[i][j] = 0;
+    }
+}
+
+
+/* c += a' * b over kb rows. On a diagonal tile, the register blocks
+   below the diagonal are skipped. */
+static inline
+void correlation_syrk_block(int kb, int diagonal,
+			    DATA_TYPE a[SYRK_DEPTH][SYRK_TILE],
+			    DATA_TYPE b[SYRK_DEPTH][SYRK_TILE],
+			    DATA_TYPE c[SYRK_TILE][SYRK_TILE])
+{
+  int i, j1, j2, x, y;
+
+  for (j1 = 0; j1 < SYRK_TILE; j1 += SYRK_MR)
+    for (j2 = diagonal ? j1 / SYRK_NR * SYRK_NR : 0; j2 < SYRK_TILE;
+	 j2 += SYRK_NR)
+      {
+	DATA_TYPE r[SYRK_MR][SYRK_NR];
+
+	for (x = 0; x < SYRK_MR; x++)
+	  for (y = 0; y < SYRK_NR; y++)
+	    r[x][y] = c[j1 + x][j2 + y];
+	for (i = 0; i < kb; i++)
+	  for (x = 0; x < SYRK_MR; x++)
+	    {
+	      DATA_TYPE ax = a[i][j1 + x];
+	      #pragma omp simd
+	      for (y = 0; y < SYRK_NR; y++)
+		r[x][y] += ax * b[i][j2 + y];
+	    }
+	for (x = 0; x < SYRK_MR; x++)
+	  for (y = 0; y < SYRK_NR; y++)
+	    c[j1 + x][j2 + y] = r[x][y];
+      }
+}
+
+
+/* Row t1 and column t2 of tile t of the upper triangle of nt x nt
+   tiles, numbered row by row. */
+static inline
+void correlation_syrk_coords(int nt, long t, int* t1, int* t2)
+{
+  *t1 = 0;
+  /* Row t1 of the triangle holds tiles t1..nt-1. */
+  while (t >= nt - *t1)
+    t -= nt - (*t1)++;
+  *t2 = *t1 + t;
+}
+
+
+/* c = tile (t1, t2) of data' * data, packing the rows through a and b. */
+static inline
+void correlation_syrk_tile(int m, int n, int t1, int t2,
+			   DATA_TYPE POLYBENCH_2D(data,N,M,n,m),
+			   DATA_TYPE a[SYRK_DEPTH][SYRK_TILE],
+			   DATA_TYPE b[SYRK_DEPTH][SYRK_TILE],
+			   DATA_TYPE c[SYRK_TILE][SYRK_TILE])
+{
+  int i0, kb;
+
+  memset (c, 0, SYRK_TILE * SYRK_TILE * sizeof(DATA_TYPE));
+  for (i0 = 0; i0 < _PB_N; i0 += SYRK_DEPTH)
+    {
+      kb = _PB_N - i0 < SYRK_DEPTH ? _PB_N - i0 : SYRK_DEPTH;
+      correlation_syrk_pack (m, n, i0, kb, t1 * SYRK_TILE, data, a);
+      if (t1 == t2)
+	correlation_syrk_block (kb, 1, a, a, c);
+      else
+	{
+	  correlation_syrk_pack (m, n, i0, kb, t2 * SYRK_TILE, data, b);
+	  correlation_syrk_block (kb, 0, a, b, c);
+	}
+    }
+}
+
+
+/* symmat = data' * data, with a unit diagonal, or with accumulate,
+   symmat += data' * data on the upper triangle only (diagonal
+   included). Must be called by all the threads of a parallel region:
+   the upper triangle of tiles is numbered row by row and split in
+   equal contiguous ranges, so that every thread gets the same number
+   of tiles whatever the shape of the triangle. */
+static
+void correlation_syrk_tiles(int m, int n,
+			    DATA_TYPE POLYBENCH_2D(data,N,M,n,m),
+			    DATA_TYPE POLYBENCH_2D(symmat,M,M,m,m),
+			    int accumulate)
+{
+  DATA_TYPE a[SYRK_DEPTH][SYRK_TILE] __attribute__ ((aligned (64)));
+  DATA_TYPE b[SYRK_DEPTH][SYRK_TILE] __attribute__ ((aligned (64)));
+  DATA_TYPE c[SYRK_TILE][SYRK_TILE] __attribute__ ((aligned (64)));
+  int nt = (_PB_M + SYRK_TILE - 1) / SYRK_TILE;
+  long t;
+
+  #pragma omp for POLYBENCH_SCHEDULE(static)
+  for (t = 0; t < (long) nt * (nt + 1) / 2; t++)
+    {
+      int t1, t2, j1, j2, x, y;
+
+      correlation_syrk_coords (nt, t, &t1, &t2);
+      correlation_syrk_tile (m, n, t1, t2, data, a, b, c);
+
+      /* Store the upper part of the tile, and mirror it. */
+      for (x = 0; x < SYRK_TILE; x++)
+	for (y = 0; y < SYRK_TILE; y++)
+	  {
+	    j1 = t1 * SYRK_TILE + x;
+	    j2 = t2 * SYRK_TILE + y;
+	    if (j1 >= _PB_M || j2 >= _PB_M || j2 < j1)
+	      continue;
+	    if (accumulate)
+	      symmat[j1][j2] += c[x][y];
+	    else if (j1 == j2)
+	      symmat[j1][j2] = 1.0;
+	    else
+	      {
+		symmat[j1][j2] = c[x][y];
+		symmat[j2][j1] = c[x][y];
+	      }
+	  }
+    }
+}
+
+
+/* symmat = data' * data, with a unit diagonal. */
+static inline
+void correlation_syrk(int m, int n,
+		      DATA_TYPE POLYBENCH_2D(data,N,M,n,m),
+		      DATA_TYPE POLYBENCH_2D(symmat,M,M,m,m))
+{
+  correlation_syrk_tiles (m, n, data, symmat, 0);
+}
+
+#endif /* !CORRELATION_SYRK_H */
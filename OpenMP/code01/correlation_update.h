@@ -0,0 +1,96 @@
+/**
+ * correlation_update.h: correlation by updates with new rows of data
+ * (correlation_ooc and correlation_inc).
+ *
+ * The state of the rows seen so far is their count, the means mu and
+ * sums of squared deviations m2 of the columns, and the co-moments of
+ * the columns (the sums of the products of their deviations from their
+ * means) in the upper triangle of an M x M array. Appending n rows costs
+ * O(n M^2), and the correlation of all the rows is recovered from the
+ * state in O(M^2).
+ */
+#ifndef CORRELATION_UPDATE_H
+# define CORRELATION_UPDATE_H
+
+# include "correlation_moments.h"
+# include "correlation_syrk.h"
+
+
+/* Append the n rows of panel to the state of count rows. The panel is
+   centered in place. mu_p and m2_p are scratch vectors of the team.
+   Must be called by all the threads of a parallel region. */
+static
+void correlation_append(int m, int n, long long count,
+			DATA_TYPE POLYBENCH_2D(panel,N,M,n,m),
+			DATA_TYPE POLYBENCH_2D(comoment,M,M,m,m),
+			DATA_TYPE* mu, DATA_TYPE* m2,
+			DATA_TYPE* mu_p, DATA_TYPE* m2_p)
+{
+  int i, j, j1, j2;
+
+  /* Moments of the panel, and co-moments of its columns centered on
+     their panel means. */
+  correlation_moments_rows (m, n, panel, mu_p, m2_p);
+  #pragma omp for POLYBENCH_SCHEDULE_DEFAULT
+  for (i = 0; i < _PB_N; i++)
+    #pragma omp simd
+    for (j = 0; j < _PB_M; j++)
+      panel[i][j] -= mu_p[j];
+  correlation_syrk_tiles (m, n, panel, comoment, 1);
+
+  /* Move the co-moments of the previous rows to the new means:
+     += count n / (count + n) (mu_p - mu) (mu_p - mu)'. */
+  if (count > 0)
+    {
+      DATA_TYPE w = (DATA_TYPE) count * n / (count + n);
+      #pragma omp for POLYBENCH_SCHEDULE(dynamic,16)
+      for (j1 = 0; j1 < _PB_M; j1++)
+	{
+	  DATA_TYPE d1 = w * (mu_p[j1] - mu[j1]);
+	  #pragma omp simd
+	  for (j2 = j1; j2 < _PB_M; j2++)
+	    comoment[j1][j2] += d1 * (mu_p[j2] - mu[j2]);
+	}
+    }
+  #pragma omp single
+  correlation_moments_merge (_PB_M, count, mu, m2, n, mu_p, m2_p);
+}
+
+
+/* mean, stddev and symmat of the kernel, from the state of count rows
+   (symmat may be comoment). The centered and reduced data of PolyBench
+   is (x - mean) / (sqrt(float_n) stddev), with its mean and stddev
+   divided by float_n rather than count: with mu the true means,
+   sum (x1 - mean1) (x2 - mean2) = co-moment + count (mu1 - mean1)
+   (mu2 - mean2). Must be called by all the threads of a parallel
+   region. */
+static
+void correlation_finish(int m, long long count, DATA_TYPE float_n,
+			DATA_TYPE eps,
+			DATA_TYPE POLYBENCH_2D(comoment,M,M,m,m),
+			DATA_TYPE* mu, DATA_TYPE* m2,
+			DATA_TYPE POLYBENCH_1D(mean,M,m),
+			DATA_TYPE POLYBENCH_1D(stddev,M,m),
+			DATA_TYPE POLYBENCH_2D(symmat,M,M,m,m))
+{
+  int j1, j2;
+
+  #pragma omp single
+  correlation_moments_finish (_PB_M, count, float_n, eps, mu, m2,
+			      mean, stddev);
+  #pragma omp for POLYBENCH_SCHEDULE(dynamic,16)
+  for (j1 = 0; j1 < _PB_M; j1++)
+    {
+      DATA_TYPE d1 = count * (mu[j1] - mean[j1]);
+      for (j2 = j1 + 1; j2 < _PB_M; j2++)
+	symmat[j1][j2] = (comoment[j1][j2] + d1 * (mu[j2] - mean[j2]))
+	  / (float_n * stddev[j1] * stddev[j2]);
+      symmat[j1][j1] = 1.0;
+    }
+  #pragma omp for POLYBENCH_SCHEDULE_DEFAULT
+  for (j1 = 0; j1 < _PB_M; j1++)
+    for (j2 = 0; j2 < j1; j2++)
+      symmat[j1][j2] = symmat[j2][j1];
+}
+
+#endif /* !CORRELATION_UPDATE_H */
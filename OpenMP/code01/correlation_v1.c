@@ -27,15 +27,15 @@ static
 void init_array (int m,
 		 int n,
 		 DATA_TYPE *float_n,
-		 DATA_TYPE POLYBENCH_2D(data,M,N,m,n))
+		 DATA_TYPE POLYBENCH_2D(data,N,M,n,m))
 {
   int i, j;
 
   *float_n = 1.2;
 
-  for (i = 0; i < m; i++)
-    for (j = 0; j < n; j++)
-      data[i][j] = ((DATA_TYPE) i*j) / M;
+  for (i = 0; i < n; i++)
+    for (j = 0; j < m; j++)
+      data[i][j] = ((DATA_TYPE) i*j) / m;
 }
 
 
@@ -62,7 +62,7 @@ void print_array(int m,
 static
 void kernel_correlation(int m, int n,
 			DATA_TYPE float_n,
-			DATA_TYPE POLYBENCH_2D(data,M,N,m,n),
+			DATA_TYPE POLYBENCH_2D(data,N,M,n,m),
 			DATA_TYPE POLYBENCH_2D(symmat,M,M,m,m),
 			DATA_TYPE POLYBENCH_1D(mean,M,m),
 			DATA_TYPE POLYBENCH_1D(stddev,M,m))
@@ -77,7 +77,9 @@ void kernel_correlation(int m, int n,
   /* Determine mean of column vectors of input data matrix */
   #pragma omp parallel
   {
-    #pragma omp for private (i)
+    polybench_region_begin ("kernel_correlation");
+    polybench_region_begin ("mean");
+    #pragma omp for private (i) POLYBENCH_SCHEDULE_DEFAULT
     for (j = 0; j < _PB_M; j++)
       {
         mean[j] = 0.0;
@@ -85,8 +87,10 @@ void kernel_correlation(int m, int n,
 	  mean[j] += data[i][j];
 	mean[j] /= float_n;
       }
+    polybench_region_end ("mean");
     /* Determine standard deviations of column vectors of data matrix. */
-    #pragma omp for private (i)
+    polybench_region_begin ("stddev");
+    #pragma omp for private (i) POLYBENCH_SCHEDULE_DEFAULT
     for (j = 0; j < _PB_M; j++)
       {
         stddev[j] = 0.0;
@@ -99,18 +103,22 @@ void kernel_correlation(int m, int n,
 	   divide. */
 	stddev[j] = stddev[j] <= eps ? 1.0 : stddev[j];
       }
+    polybench_region_end ("stddev");
     
     /* Center and reduce the column vectors. */
-    #pragma omp for private (j)
+    polybench_region_begin ("center");
+    #pragma omp for private (j) POLYBENCH_SCHEDULE_DEFAULT
     for (i = 0; i < _PB_N; i++)
       for (j = 0; j < _PB_M; j++)
 	{
           data[i][j] -= mean[j];
           data[i][j] /= sqrt(float_n) * stddev[j];
 	}
+    polybench_region_end ("center");
     
     /* Calculate the m * m correlation matrix. */
-    #pragma omp for private (j2, i)
+    polybench_region_begin ("symmat");
+    #pragma omp for private (j2, i) POLYBENCH_SCHEDULE_DEFAULT
     for (j1 = 0; j1 < _PB_M-1; j1++)
       {
         symmat[j1][j1] = 1.0;
@@ -122,6 +130,8 @@ void kernel_correlation(int m, int n,
 	    symmat[j2][j1] = symmat[j1][j2];
           }
       }
+    polybench_region_end ("symmat");
+    polybench_region_end ("kernel_correlation");
   }
   #pragma endscop
   symmat[_PB_M-1][_PB_M-1] = 1.0;
@@ -130,35 +140,49 @@ void kernel_correlation(int m, int n,
 int main(int argc, char** argv)
 {
   /* Retrieve problem size. */
-  int n = N;
-  int m = M;
+  int n = POLYBENCH_SIZE(N);
+  int m = POLYBENCH_SIZE(M);
+
+  /* Flops and compulsory memory traffic, for the GFLOP/s and roofline
+     reports. */
+  polybench_set_program_flops ((double) n * m * (m - 1) + 6.0 * n * m + 4.0 * m);
+  polybench_set_program_bytes ((2.0 * n * m + (double) m * m) * sizeof(DATA_TYPE));
 
   /* Variable declaration/allocation. */
   DATA_TYPE float_n;
-  POLYBENCH_2D_ARRAY_DECL(data,DATA_TYPE,M,N,m,n);
+  POLYBENCH_2D_ARRAY_DECL(data,DATA_TYPE,N,M,n,m);
   POLYBENCH_2D_ARRAY_DECL(symmat,DATA_TYPE,M,M,m,m);
   POLYBENCH_1D_ARRAY_DECL(mean,DATA_TYPE,M,m);
   POLYBENCH_1D_ARRAY_DECL(stddev,DATA_TYPE,M,m);
 
-  /* Initialize array(s). */
-  init_array (m, n, &float_n, POLYBENCH_ARRAY(data));
-  
-  /* Start timer. */
-  polybench_start_instruments;
-  /* Run kernel. */
-  kernel_correlation (m, n, float_n,
-		      POLYBENCH_ARRAY(data),
-		      POLYBENCH_ARRAY(symmat),
-		      POLYBENCH_ARRAY(mean),
-		      POLYBENCH_ARRAY(stddev));
-  /* Stop and print timer. */
-  polybench_stop_instruments;
+  /* Run the kernel once per repetition (see polybench.h). */
+  polybench_repeat
+    {
+      /* Initialize array(s). */
+      init_array (m, n, &float_n, POLYBENCH_ARRAY(data));
+
+      /* Start timer. */
+      polybench_start_instruments;
+      /* Run kernel. */
+      kernel_correlation (m, n, float_n,
+			  POLYBENCH_ARRAY(data),
+			  POLYBENCH_ARRAY(symmat),
+			  POLYBENCH_ARRAY(mean),
+			  POLYBENCH_ARRAY(stddev));
+
+      /* Stop timer. */
+      polybench_stop_instruments;
+    }
+  /* Print timer. */
   polybench_print_instruments;
   
   /* Prevent dead-code elimination. All live-out data must be printed
      by the function call in argument. */
   polybench_prevent_dce(print_array(m, POLYBENCH_ARRAY(symmat)));
 
+  /* Check the output, as selected with POLYBENCH_VERIFY. */
+  polybench_verify_2d (symmat, m, m);
+
   /* Be clean. */
   POLYBENCH_FREE_ARRAY(data);
   POLYBENCH_FREE_ARRAY(symmat);
@@ -0,0 +1,160 @@
+/* POLYBENCH/GPU-OPENMP
+ *
+ * This file is a part of the Polybench/GPU-OpenMP suite
+ *
+ * Contact:
+ * William Killian <killian@udel.edu>
+ * 
+ * Copyright 2013, The University of Delaware
+ */
+#define EXTRALARGE_DATASET
+
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <math.h>
+
+/* Include polybench common header. */
+#include <polybench.h>
+
+/* Include benchmark-specific header. */
+/* Default data type is double, default size is 4000. */
+#include "correlation.h"
+#include "correlation_moments.h"
+#include "correlation_syrk.h"
+
+
+/* Array initialization. */
+static
+void init_array (int m,
+		 int n,
+		 DATA_TYPE *float_n,
+		 DATA_TYPE POLYBENCH_2D(data,N,M,n,m))
+{
+  int i, j;
+
+  *float_n = 1.2;
+
+  for (i = 0; i < n; i++)
+    for (j = 0; j < m; j++)
+      data[i][j] = ((DATA_TYPE) i*j) / m;
+}
+
+
+/* DCE code. Must scan the entire live-out data.
+   Can be used also to check the correctness of the output. */
+static
+void print_array(int m,
+		 DATA_TYPE POLYBENCH_2D(symmat,M,M,m,m))
+
+{
+  int i, j;
+
+  for (i = 0; i < m; i++)
+    for (j = 0; j < m; j++) {
+      fprintf (stderr, DATA_PRINTF_MODIFIER, symmat[i][j]);
+      if ((i * m + j) % 20 == 0) fprintf (stderr, "\n");
+    }
+  fprintf (stderr, "\n");
+}
+
+
+/* Main computational kernel. The whole function will be timed,
+   including the call and return. */
+static
+void kernel_correlation(int m, int n,
+			DATA_TYPE float_n,
+			DATA_TYPE POLYBENCH_2D(data,N,M,n,m),
+			DATA_TYPE POLYBENCH_2D(symmat,M,M,m,m),
+			DATA_TYPE POLYBENCH_1D(mean,M,m),
+			DATA_TYPE POLYBENCH_1D(stddev,M,m))
+{
+  int i, j;
+
+  DATA_TYPE eps = 0.1f;
+  double sqrt_float_n = sqrt(float_n);
+
+  #pragma scop
+  #pragma omp parallel
+  {
+    polybench_region_begin ("kernel_correlation");
+    /* Determine mean and standard deviations of column vectors of
+       data matrix, in one pass over its rows (see
+       correlation_moments.h). */
+    polybench_region_begin ("moments");
+    correlation_moments (m, n, float_n, eps, data, mean, stddev);
+    polybench_region_end ("moments");
+
+    /* Center and reduce the column vectors, in a second pass. */
+    polybench_region_begin ("center");
+    #pragma omp for private (j) POLYBENCH_SCHEDULE_DEFAULT
+    for (i = 0; i < _PB_N; i++)
+      #pragma omp simd
+      for (j = 0; j < _PB_M; j++)
+	data[i][j] = (data[i][j] - mean[j]) / (sqrt_float_n * stddev[j]);
+    polybench_region_end ("center");
+
+    /* Calculate the m * m correlation matrix, by tiles of the upper
+       triangle (see correlation_syrk.h). */
+    polybench_region_begin ("symmat");
+    correlation_syrk (m, n, data, symmat);
+    polybench_region_end ("symmat");
+    polybench_region_end ("kernel_correlation");
+  }
+  #pragma endscop
+}
+
+int main(int argc, char** argv)
+{
+  /* Retrieve problem size. */
+  int n = POLYBENCH_SIZE(N);
+  int m = POLYBENCH_SIZE(M);
+
+  /* Flops and compulsory memory traffic, for the GFLOP/s and roofline
+     reports. */
+  polybench_set_program_flops ((double) n * m * (m - 1) + 6.0 * n * m + 4.0 * m);
+  polybench_set_program_bytes ((2.0 * n * m + (double) m * m) * sizeof(DATA_TYPE));
+
+  /* Variable declaration/allocation. */
+  DATA_TYPE float_n;
+  POLYBENCH_2D_ARRAY_DECL(data,DATA_TYPE,N,M,n,m);
+  POLYBENCH_2D_ARRAY_DECL(symmat,DATA_TYPE,M,M,m,m);
+  POLYBENCH_1D_ARRAY_DECL(mean,DATA_TYPE,M,m);
+  POLYBENCH_1D_ARRAY_DECL(stddev,DATA_TYPE,M,m);
+
+  /* Run the kernel once per repetition (see polybench.h). */
+  polybench_repeat
+    {
+      /* Initialize array(s). */
+      init_array (m, n, &float_n, POLYBENCH_ARRAY(data));
+
+      /* Start timer. */
+      polybench_start_instruments;
+      /* Run kernel. */
+      kernel_correlation (m, n, float_n,
+			  POLYBENCH_ARRAY(data),
+			  POLYBENCH_ARRAY(symmat),
+			  POLYBENCH_ARRAY(mean),
+			  POLYBENCH_ARRAY(stddev));
+
+      /* Stop timer. */
+      polybench_stop_instruments;
+    }
+  /* Print timer. */
+  polybench_print_instruments;
+  
+  /* Prevent dead-code elimination. All live-out data must be printed
+     by the function call in argument. */
+  polybench_prevent_dce(print_array(m, POLYBENCH_ARRAY(symmat)));
+
+  /* Check the output, as selected with POLYBENCH_VERIFY. */
+  polybench_verify_2d (symmat, m, m);
+
+  /* Be clean. */
+  POLYBENCH_FREE_ARRAY(data);
+  POLYBENCH_FREE_ARRAY(symmat);
+  POLYBENCH_FREE_ARRAY(mean);
+  POLYBENCH_FREE_ARRAY(stddev);
+
+  return 0;
+}
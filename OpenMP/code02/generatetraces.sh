@@ -1,3 +1,5 @@
 #!/bin/bash
 day=`date '+%d'`
-srun --time=00:10:00 -c 24 --mem=32G ../../common/subOMP.sh trmm_v0 trmm_v1
+srun --time=00:10:00 -c 24 --mem=32G ../../common/subOMP.sh trmm_v0 trmm_v1 trmm_v2 trmm_v3 trmm_v4 trmm_v5
+# Task graph of trmm_v5 (trmm_v5_tasks.prv), traced by polybench itself.
+srun --time=00:10:00 -c 24 --mem=32G env OMP_NUM_THREADS=24 POLYBENCH_TRACE=trmm_v5_tasks ./trmm_v5_trace
@@ -0,0 +1,183 @@
+/**
+ * trmm_pack.h: packed panels and register-blocked micro-kernel for
+ * kernel_trmm (trmm_v4).
+ *
+ * A block of rows i0..i1-1 of B is updated with a panel of A packed by
+ * micro-panels of TRMM_MR rows (alpha folded in), and panels of rows of
+ * B packed by micro-panels of TRMM_NR rows, so that the micro-kernel
+ * streams both contiguously. Each element still receives its terms in
+ * increasing k, so that the result is the one of the sequential loop.
+ */
+#ifndef TRMM_PACK_H
+# define TRMM_PACK_H
+
+/* Rows of B updated at a time. A multiple of TRMM_NB and TRMM_MR. */
+# ifndef TRMM_MB
+#  define TRMM_MB 64
+# endif
+
+/* Columns of B updated by a task. A multiple of TRMM_NR. */
+# ifndef TRMM_NB
+#  define TRMM_NB 32
+# endif
+
+/* Depth (k) packed at a time: the packed panel of B (TRMM_KB x TRMM_NB
+   doubles) stays in L2. */
+# ifndef TRMM_KB
+#  define TRMM_KB 256
+# endif
+
+/* Register block of the micro-kernel, TRMM_MR x TRMM_NR accumulators
+   (trmm_micro is written out for TRMM_MR = 4). */
+# define TRMM_MR 4
+# define TRMM_NR 8
+
+/* The column panels of trmm_v4 are either inside or outside a block of
+   rows, and the packed panels of B hold whole micro-panels. */
+# if TRMM_MB % TRMM_NB || TRMM_MB % TRMM_MR || TRMM_NB % TRMM_NR
+#  error "TRMM_MB must be a multiple of TRMM_NB and TRMM_MR, and TRMM_NB of TRMM_NR"
+# endif
+
+
+/* Micro-panel p of ap[p][k][x] = alpha * A[i0 + p TRMM_MR + x][k], for
+   k < i1, padded with zeros past row i1 - 1. */
+static inline
+void trmm_pack_a(int ni, int i0, int i1, int p, DATA_TYPE alpha,
+		 DATA_TYPE POLYBENCH_2D(A,NI,NI,ni,ni),
+		 DATA_TYPE* ap)
+{
+  int k, x;
+
+  for (k = 0; k < i1; k++)
+    for (x = 0; x < TRMM_MR; x++)
+      {
+	int i = i0 + p * TRMM_MR + x;
+	ap[((size_t) p * i1 + k) * TRMM_MR + x] = i < i1 ? alpha * A[i][k] : 0;
+      }
+}
+
+
+/* bp[q][k][y] = B[j0 + q TRMM_NR + y][k0 + k], for k < kb, padded with
+   zeros past row j1 - 1. */
+static inline
+void trmm_pack_b(int ni, int j0, int j1, int k0, int kb,
+		 DATA_TYPE POLYBENCH_2D(B,NI,NI,ni,ni),
+		 DATA_TYPE bp[TRMM_NB / TRMM_NR][TRMM_KB][TRMM_NR])
+{
+  int q, k, y;
+
+  for (q = 0; q < TRMM_NB / TRMM_NR; q++)
+    for (y = 0; y < TRMM_NR; y++)
+      {
+	int j = j0 + q * TRMM_NR + y;
+	for (k = 0; k < kb; k++)
+	  bp[q][k][y] = j < j1 ? B[j][k0 + k] : 0;
+      }
+}
+
+
+/* r += a * b' over kb packed rows: the full tiles. */
+static inline
+void trmm_micro(int kb, const DATA_TYPE* a,
+		DATA_TYPE b[][TRMM_NR],
+		DATA_TYPE r[TRMM_MR][TRMM_NR])
+{
+  DATA_TYPE r0[TRMM_NR], r1[TRMM_NR], r2[TRMM_NR], r3[TRMM_NR];
+  int k, y;
+
+  for (y = 0; y < TRMM_NR; y++)
+    {
+      r0[y] = r[0][y];
+      r1[y] = r[1][y];
+      r2[y] = r[2][y];
+      r3[y] = r[3][y];
+    }
+  for (k = 0; k < kb; k++)
+    {
+      #pragma omp simd
+      for (y = 0; y < TRMM_NR; y++)
+	{
+	  r0[y] += a[k * TRMM_MR + 0] * b[k][y];
+	  r1[y] += a[k * TRMM_MR + 1] * b[k][y];
+	  r2[y] += a[k * TRMM_MR + 2] * b[k][y];
+	  r3[y] += a[k * TRMM_MR + 3] * b[k][y];
+	}
+    }
+  for (y = 0; y < TRMM_NR; y++)
+    {
+      r[0][y] = r0[y];
+      r[1][y] = r1[y];
+      r[2][y] = r2[y];
+      r[3][y] = r3[y];
+    }
+}
+
+
+/* The same across the diagonal of A: row x of the tile only takes the
+   terms k0 + k < row0 + x. */
+static inline
+void trmm_micro_masked(int kb, int k0, int row0, const DATA_TYPE* a,
+		       DATA_TYPE b[][TRMM_NR],
+		       DATA_TYPE r[TRMM_MR][TRMM_NR])
+{
+  int k, x, y;
+
+  for (k = 0; k < kb; k++)
+    for (x = 0; x < TRMM_MR; x++)
+      if (k0 + k < row0 + x)
+	{
+	  #pragma omp simd
+	  for (y = 0; y < TRMM_NR; y++)
+	    r[x][y] += a[k * TRMM_MR + x] * b[k][y];
+	}
+}
+
+
+/* Columns j0..j1-1 of the rows i0..i1-1 of B, from the packed panel of
+   A and the rows j0..j1-1 of B (outside i0..i1-1). The full part of the
+   tiles runs unmasked, and only the last TRMM_MR - 1 terms of a tile,
+   across the diagonal of A, are masked. */
+static
+void trmm_update_block(int ni, int i0, int i1, int j0, int j1,
+		       const DATA_TYPE* ap,
+		       DATA_TYPE POLYBENCH_2D(B,NI,NI,ni,ni),
+		       DATA_TYPE bp[TRMM_NB / TRMM_NR][TRMM_KB][TRMM_NR])
+{
+  DATA_TYPE r[TRMM_MR][TRMM_NR];
+  int k0, kb, x0, q, x, y, full, tail;
+
+  /* Row i1 - 1 takes the terms k < i1 - 1. */
+  for (k0 = 0; k0 < i1 - 1; k0 += TRMM_KB)
+    {
+      kb = i1 - 1 - k0 < TRMM_KB ? i1 - 1 - k0 : TRMM_KB;
+      trmm_pack_b (ni, j0, j1, k0, kb, B, bp);
+      for (x0 = i0; x0 < i1; x0 += TRMM_MR)
+	{
+	  const DATA_TYPE* a = ap + ((size_t) (x0 - i0) / TRMM_MR * i1 + k0) * TRMM_MR;
+
+	  /* Terms k < x0 are taken by all the rows of the tile. */
+	  full = x0 - k0 < kb ? x0 - k0 : kb;
+	  full = full < 0 ? 0 : full;
+	  tail = (x0 + TRMM_MR - 1 - k0 < kb ? x0 + TRMM_MR - 1 - k0 : kb) - full;
+	  if (full + tail <= 0)
+	    continue;
+	  for (q = 0; q * TRMM_NR < j1 - j0; q++)
+	    {
+	      for (x = 0; x < TRMM_MR; x++)
+		for (y = 0; y < TRMM_NR; y++)
+		  r[x][y] = x0 + x < i1 && j0 + q * TRMM_NR + y < j1
+		    ? B[x0 + x][j0 + q * TRMM_NR + y] : 0;
+	      if (full > 0)
+		trmm_micro (full, a, bp[q], r);
+	      if (tail > 0)
+		trmm_micro_masked (tail, k0 + full, x0, a + (size_t) full * TRMM_MR,
+				   bp[q] + full, r);
+	      for (x = 0; x < TRMM_MR && x0 + x < i1; x++)
+		for (y = 0; y < TRMM_NR && j0 + q * TRMM_NR + y < j1; y++)
+		  B[x0 + x][j0 + q * TRMM_NR + y] = r[x][y];
+	    }
+	}
+    }
+}
+
+#endif /* !TRMM_PACK_H */
@@ -0,0 +1,60 @@
+/**
+ * trmm_partition.h: work-balanced partitions of the triangular
+ * iteration space of kernel_trmm (trmm_v2 and trmm_v3).
+ *
+ * Row i of B costs i multiply-adds per column, so that rows 1..r-1
+ * cost r (r - 1) / 2 of them per column: the row where a given share of
+ * the work starts is the positive root of this quadratic.
+ */
+#ifndef TRMM_PARTITION_H
+# define TRMM_PARTITION_H
+
+# include <math.h>
+# ifdef _OPENMP
+#  include <omp.h>
+# endif
+
+
+/* First row of part t of nb_parts parts of equal work of rows
+   1..ni-1 (ni for t = nb_parts). */
+static inline
+int trmm_partition_row(int ni, int t, int nb_parts)
+{
+  double work = (double) ni * (ni - 1) / 2 * t / nb_parts;
+  int r = (int) floor ((1 + sqrt (1 + 8 * work)) / 2 + 0.5);
+
+  return r < 1 ? 1 : r > ni ? ni : r;
+}
+
+
+/* Contiguous rows first..last-1 of the calling thread, with the same
+   work in every thread. */
+static inline
+void trmm_partition_balanced(int ni, int* first, int* last)
+{
+  int tid = 0, nb_threads = 1;
+
+# ifdef _OPENMP
+  tid = omp_get_thread_num ();
+  nb_threads = omp_get_num_threads ();
+# endif
+  *first = trmm_partition_row (ni, tid, nb_threads);
+  *last = trmm_partition_row (ni, tid + 1, nb_threads);
+}
+
+
+/* Row i of B := alpha*A'*B. */
+static inline
+void trmm_row(int ni, int i,
+	      DATA_TYPE alpha,
+	      DATA_TYPE POLYBENCH_2D(A,NI,NI,ni,ni),
+	      DATA_TYPE POLYBENCH_2D(B,NI,NI,ni,ni))
+{
+  int j, k;
+
+  for (j = 0; j < _PB_NI; j++)
+    for (k = 0; k < i; k++)
+      B[i][j] += alpha * A[i][k] * B[j][k];
+}
+
+#endif /* !TRMM_PARTITION_H */
@@ -67,12 +67,17 @@ void kernel_trmm(int ni,
   #pragma scop
   #pragma omp parallel
   {
+    polybench_region_begin ("kernel_trmm");
+    polybench_thread_begin ();
     /*  B := alpha*A'*B, A triangular */
-    #pragma omp for private (j, k)
+    #pragma omp for private (j, k) POLYBENCH_SCHEDULE_DEFAULT nowait
     for (i = 1; i < _PB_NI; i++)
       for (j = 0; j < _PB_NI; j++)
 	for (k = 0; k < i; k++)
 	  B[i][j] += alpha * A[i][k] * B[j][k];
+    /* Arrival at the barrier closing the parallel region. */
+    polybench_thread_end ();
+    polybench_region_end ("kernel_trmm");
   }
   #pragma endscop
 }
@@ -81,30 +86,43 @@ void kernel_trmm(int ni,
 int main(int argc, char** argv)
 {
   /* Retrieve problem size. */
-  int ni = NI;
+  int ni = POLYBENCH_SIZE(NI);
+
+  /* Flops and compulsory memory traffic, for the GFLOP/s and roofline
+     reports. */
+  polybench_set_program_flops (3.0 * ni * ni * (ni - 1) / 2);
+  polybench_set_program_bytes (3.0 * ni * ni * sizeof(DATA_TYPE));
 
   /* Variable declaration/allocation. */
   DATA_TYPE alpha;
   POLYBENCH_2D_ARRAY_DECL(A,DATA_TYPE,NI,NI,ni,ni);
   POLYBENCH_2D_ARRAY_DECL(B,DATA_TYPE,NI,NI,ni,ni);
 
-  /* Initialize array(s). */
-  init_array (ni, &alpha, POLYBENCH_ARRAY(A), POLYBENCH_ARRAY(B));
+  /* Run the kernel once per repetition (see polybench.h). */
+  polybench_repeat
+    {
+      /* Initialize array(s). */
+      init_array (ni, &alpha, POLYBENCH_ARRAY(A), POLYBENCH_ARRAY(B));
 
-  /* Start timer. */
-  polybench_start_instruments;
+      /* Start timer. */
+      polybench_start_instruments;
 
-  /* Run kernel. */
-  kernel_trmm (ni, alpha, POLYBENCH_ARRAY(A), POLYBENCH_ARRAY(B));
+      /* Run kernel. */
+      kernel_trmm (ni, alpha, POLYBENCH_ARRAY(A), POLYBENCH_ARRAY(B));
 
-  /* Stop and print timer. */
-  polybench_stop_instruments;
+      /* Stop timer. */
+      polybench_stop_instruments;
+    }
+  /* Print timer. */
   polybench_print_instruments;
 
   /* Prevent dead-code elimination. All live-out data must be printed
      by the function call in argument. */
   polybench_prevent_dce(print_array(ni, POLYBENCH_ARRAY(B)));
 
+  /* Check the output, as selected with POLYBENCH_VERIFY. */
+  polybench_verify_2d (B, ni, ni);
+
   /* Be clean. */
   POLYBENCH_FREE_ARRAY(A);
   POLYBENCH_FREE_ARRAY(B);
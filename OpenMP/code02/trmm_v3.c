@@ -0,0 +1,139 @@
+/* POLYBENCH/GPU-OPENMP
+ *
+ * This file is a part of the Polybench/GPU-OpenMP suite
+ *
+ * Contact:
+ * William Killian <killian@udel.edu>
+ * 
+ * Copyright 2013, The University of Delaware
+ */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <math.h>
+
+/* Include polybench common header. */
+#include <polybench.h>
+
+/* Include benchmark-specific header. */
+/* Default data type is double, default size is 4000. */
+#include "trmm.h"
+#include "trmm_partition.h"
+
+
+/* Array initialization. */
+static
+void init_array(int ni,
+		DATA_TYPE *alpha,
+		DATA_TYPE POLYBENCH_2D(A,NI,NI,ni,ni),
+		DATA_TYPE POLYBENCH_2D(B,NI,NI,ni,ni))
+{
+  int i, j;
+
+  *alpha = 32412;
+  for (i = 0; i < ni; i++)
+    for (j = 0; j < ni; j++) {
+      A[i][j] = ((DATA_TYPE) i*j) / ni;
+      B[i][j] = ((DATA_TYPE) i*j) / ni;
+    }
+}
+
+
+/* DCE code. Must scan the entire live-out data.
+   Can be used also to check the correctness of the output. */
+static
+void print_array(int ni,
+		 DATA_TYPE POLYBENCH_2D(B,NI,NI,ni,ni))
+{
+  int i, j;
+
+  for (i = 0; i < ni; i++)
+    for (j = 0; j < ni; j++) {
+	fprintf (stderr, DATA_PRINTF_MODIFIER, B[i][j]);
+	if ((i * ni + j) % 20 == 0) fprintf (stderr, "\n");
+    }
+  fprintf (stderr, "\n");
+}
+
+
+/* Main computational kernel. The whole function will be timed,
+   including the call and return. */
+static
+void kernel_trmm(int ni,
+		 DATA_TYPE alpha,
+		 DATA_TYPE POLYBENCH_2D(A,NI,NI,ni,ni),
+		 DATA_TYPE POLYBENCH_2D(B,NI,NI,ni,ni))
+{
+  int p;
+  #pragma scop
+  #pragma omp parallel
+  {
+    polybench_region_begin ("kernel_trmm");
+    polybench_thread_begin ();
+    /*  B := alpha*A'*B, A triangular. Short row 1 + p is paired with
+	long row ni - 1 - p, so that all the pairs have the same work
+	and a static split of the pairs is balanced: the split is the
+	algorithm, and stays static with POLYBENCH_RUNTIME_SCHEDULE. Row
+	i reads the other rows of B, so that, as in trmm_v0 with several
+	threads, the result depends on the order of the rows. */
+    #pragma omp for schedule(static) nowait
+    for (p = 0; p < _PB_NI / 2; p++)
+      {
+	trmm_row (ni, 1 + p, alpha, A, B);
+	if (_PB_NI - 1 - p != 1 + p)
+	  trmm_row (ni, _PB_NI - 1 - p, alpha, A, B);
+      }
+    /* Arrival at the barrier closing the parallel region. */
+    polybench_thread_end ();
+    polybench_region_end ("kernel_trmm");
+  }
+  #pragma endscop
+}
+
+
+int main(int argc, char** argv)
+{
+  /* Retrieve problem size. */
+  int ni = POLYBENCH_SIZE(NI);
+
+  /* Flops and compulsory memory traffic, for the GFLOP/s and roofline
+     reports. */
+  polybench_set_program_flops (3.0 * ni * ni * (ni - 1) / 2);
+  polybench_set_program_bytes (3.0 * ni * ni * sizeof(DATA_TYPE));
+
+  /* Variable declaration/allocation. */
+  DATA_TYPE alpha;
+  POLYBENCH_2D_ARRAY_DECL(A,DATA_TYPE,NI,NI,ni,ni);
+  POLYBENCH_2D_ARRAY_DECL(B,DATA_TYPE,NI,NI,ni,ni);
+
+  /* Run the kernel once per repetition (see polybench.h). */
+  polybench_repeat
+    {
+      /* Initialize array(s). */
+      init_array (ni, &alpha, POLYBENCH_ARRAY(A), POLYBENCH_ARRAY(B));
+
+      /* Start timer. */
+      polybench_start_instruments;
+
+      /* Run kernel. */
+      kernel_trmm (ni, alpha, POLYBENCH_ARRAY(A), POLYBENCH_ARRAY(B));
+
+      /* Stop timer. */
+      polybench_stop_instruments;
+    }
+  /* Print timer. */
+  polybench_print_instruments;
+
+  /* Prevent dead-code elimination. All live-out data must be printed
+     by the function call in argument. */
+  polybench_prevent_dce(print_array(ni, POLYBENCH_ARRAY(B)));
+
+  /* Check the output, as selected with POLYBENCH_VERIFY. */
+  polybench_verify_2d (B, ni, ni);
+
+  /* Be clean. */
+  POLYBENCH_FREE_ARRAY(A);
+  POLYBENCH_FREE_ARRAY(B);
+
+  return 0;
+}
@@ -0,0 +1,187 @@
+/* POLYBENCH/GPU-OPENMP
+ *
+ * This file is a part of the Polybench/GPU-OpenMP suite
+ *
+ * Contact:
+ * William Killian <killian@udel.edu>
+ * 
+ * Copyright 2013, The University of Delaware
+ */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <math.h>
+
+/* Include polybench common header. */
+#include <polybench.h>
+
+/* Include benchmark-specific header. */
+/* Default data type is double, default size is 4000. */
+#include "trmm.h"
+#include "trmm_pack.h"
+
+
+/* Array initialization. */
+static
+void init_array(int ni,
+		DATA_TYPE *alpha,
+		DATA_TYPE POLYBENCH_2D(A,NI,NI,ni,ni),
+		DATA_TYPE POLYBENCH_2D(B,NI,NI,ni,ni))
+{
+  int i, j;
+
+  *alpha = 32412;
+  for (i = 0; i < ni; i++)
+    for (j = 0; j < ni; j++) {
+      A[i][j] = ((DATA_TYPE) i*j) / ni;
+      B[i][j] = ((DATA_TYPE) i*j) / ni;
+    }
+}
+
+
+/* DCE code. Must scan the entire live-out data.
+   Can be used also to check the correctness of the output. */
+static
+void print_array(int ni,
+		 DATA_TYPE POLYBENCH_2D(B,NI,NI,ni,ni))
+{
+  int i, j;
+
+  for (i = 0; i < ni; i++)
+    for (j = 0; j < ni; j++) {
+	fprintf (stderr, DATA_PRINTF_MODIFIER, B[i][j]);
+	if ((i * ni + j) % 20 == 0) fprintf (stderr, "\n");
+    }
+  fprintf (stderr, "\n");
+}
+
+
+/* Main computational kernel. The whole function will be timed,
+   including the call and return. */
+static
+void kernel_trmm(int ni,
+		 DATA_TYPE alpha,
+		 DATA_TYPE POLYBENCH_2D(A,NI,NI,ni,ni),
+		 DATA_TYPE POLYBENCH_2D(B,NI,NI,ni,ni))
+{
+  /* Packed panel of A, and rows of B before their update, for a block
+     of TRMM_MB rows (see trmm_pack.h). */
+  DATA_TYPE* ap = (DATA_TYPE*) polybench_alloc_data ((size_t) TRMM_MB * ni, sizeof(DATA_TYPE));
+  DATA_TYPE* b0 = (DATA_TYPE*) polybench_alloc_data ((size_t) TRMM_MB * ni, sizeof(DATA_TYPE));
+  int i0, i1, i, j, k, jb, p;
+  #pragma scop
+  #pragma omp parallel private (i0, i1, i, j, k, jb, p)
+  {
+    DATA_TYPE bp[TRMM_NB / TRMM_NR][TRMM_KB][TRMM_NR] __attribute__((aligned (64)));
+
+    polybench_region_begin ("kernel_trmm");
+    polybench_thread_begin ();
+    /*  B := alpha*A'*B, A triangular, by blocks of rows. Row i reads the
+	rows j < i once updated and the rows j > i before, as in the
+	sequential loop: the rows before i0 are done, the rows after i1
+	are not started, and the rows i0..i1-1 are saved in b0. */
+    for (i0 = 0; i0 < _PB_NI; i0 += TRMM_MB)
+      {
+	i1 = i0 + TRMM_MB < _PB_NI ? i0 + TRMM_MB : _PB_NI;
+	#pragma omp for POLYBENCH_SCHEDULE_DEFAULT
+	for (p = 0; p < (i1 - i0 + TRMM_MR - 1) / TRMM_MR; p++)
+	  trmm_pack_a (ni, i0, i1, p, alpha, A, ap);
+	#pragma omp for POLYBENCH_SCHEDULE_DEFAULT
+	for (i = i0; i < i1; i++)
+	  memcpy (b0 + (size_t) (i - i0) * ni, B[i], i1 * sizeof(DATA_TYPE));
+
+	/* Columns outside i0..i1-1, by packed panels of TRMM_NB columns. */
+	polybench_region_begin ("panels");
+	#pragma omp for POLYBENCH_SCHEDULE(dynamic,1)
+	for (jb = 0; jb < (_PB_NI + TRMM_NB - 1) / TRMM_NB; jb++)
+	  if (jb * TRMM_NB >= i1 || jb * TRMM_NB + TRMM_NB <= i0)
+	    trmm_update_block (ni, i0, i1, jb * TRMM_NB,
+			       jb * TRMM_NB + TRMM_NB < _PB_NI ? jb * TRMM_NB + TRMM_NB : _PB_NI,
+			       ap, B, bp);
+	polybench_region_end ("panels");
+
+	/* Diagonal block, terms k < i0: the rows j <= i are updated up
+	   to column i0 - 1, and the rows j > i are read from b0. */
+	polybench_region_begin ("diagonal");
+	#pragma omp for private (j, k) POLYBENCH_SCHEDULE_DEFAULT
+	for (i = i0; i < i1; i++)
+	  for (j = i0; j < i1; j++)
+	    {
+	      const DATA_TYPE* a = ap + (size_t) (i - i0) / TRMM_MR * i1 * TRMM_MR + (i - i0) % TRMM_MR;
+	      const DATA_TYPE* x = j <= i ? B[j] : b0 + (size_t) (j - i0) * ni;
+	      DATA_TYPE s = B[i][j];
+	      for (k = 0; k < i0; k++)
+		s += a[k * TRMM_MR] * x[k];
+	      B[i][j] = s;
+	    }
+
+	/* Terms i0 <= k < i, in the order of the sequential loop. */
+	#pragma omp single
+	for (i = i0 + 1; i < i1; i++)
+	  for (j = i0; j < i1; j++)
+	    {
+	      const DATA_TYPE* a = ap + (size_t) (i - i0) / TRMM_MR * i1 * TRMM_MR + (i - i0) % TRMM_MR;
+	      const DATA_TYPE* x = j <= i ? B[j] : b0 + (size_t) (j - i0) * ni;
+	      DATA_TYPE s = B[i][j];
+	      for (k = i0; k < i; k++)
+		s += a[k * TRMM_MR] * x[k];
+	      B[i][j] = s;
+	    }
+	polybench_region_end ("diagonal");
+      }
+    /* Arrival at the barrier closing the parallel region. */
+    polybench_thread_end ();
+    polybench_region_end ("kernel_trmm");
+  }
+  #pragma endscop
+  polybench_free_data (ap);
+  polybench_free_data (b0);
+}
+
+
+int main(int argc, char** argv)
+{
+  /* Retrieve problem size. */
+  int ni = POLYBENCH_SIZE(NI);
+
+  /* Flops and compulsory memory traffic, for the GFLOP/s and roofline
+     reports. */
+  polybench_set_program_flops (3.0 * ni * ni * (ni - 1) / 2);
+  polybench_set_program_bytes (3.0 * ni * ni * sizeof(DATA_TYPE));
+
+  /* Variable declaration/allocation. */
+  DATA_TYPE alpha;
+  POLYBENCH_2D_ARRAY_DECL(A,DATA_TYPE,NI,NI,ni,ni);
+  POLYBENCH_2D_ARRAY_DECL(B,DATA_TYPE,NI,NI,ni,ni);
+
+  /* Run the kernel once per repetition (see polybench.h). */
+  polybench_repeat
+    {
+      /* Initialize array(s). */
+      init_array (ni, &alpha, POLYBENCH_ARRAY(A), POLYBENCH_ARRAY(B));
+
+      /* Start timer. */
+      polybench_start_instruments;
+
+      /* Run kernel. */
+      kernel_trmm (ni, alpha, POLYBENCH_ARRAY(A), POLYBENCH_ARRAY(B));
+
+      /* Stop timer. */
+      polybench_stop_instruments;
+    }
+  /* Print timer. */
+  polybench_print_instruments;
+
+  /* Prevent dead-code elimination. All live-out data must be printed
+     by the function call in argument. */
+  polybench_prevent_dce(print_array(ni, POLYBENCH_ARRAY(B)));
+
+  /* Check the output, as selected with POLYBENCH_VERIFY. */
+  polybench_verify_2d (B, ni, ni);
+
+  /* Be clean. */
+  POLYBENCH_FREE_ARRAY(A);
+  POLYBENCH_FREE_ARRAY(B);
+
+  return 0;
+}
@@ -0,0 +1,269 @@
+/* POLYBENCH/GPU-OPENMP
+ *
+ * This file is a part of the Polybench/GPU-OpenMP suite
+ *
+ * Contact:
+ * William Killian <killian@udel.edu>
+ * 
+ * Copyright 2013, The University of Delaware
+ */
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <math.h>
+
+/* Include polybench common header. */
+#include <polybench.h>
+
+/* Include benchmark-specific header. */
+/* Default data type is double, default size is 4000. */
+#include "trmm.h"
+#include "trmm_pack.h"
+
+
+/* Array initialization. */
+static
+void init_array(int ni,
+		DATA_TYPE *alpha,
+		DATA_TYPE POLYBENCH_2D(A,NI,NI,ni,ni),
+		DATA_TYPE POLYBENCH_2D(B,NI,NI,ni,ni))
+{
+  int i, j;
+
+  *alpha = 32412;
+  for (i = 0; i < ni; i++)
+    for (j = 0; j < ni; j++) {
+      A[i][j] = ((DATA_TYPE) i*j) / ni;
+      B[i][j] = ((DATA_TYPE) i*j) / ni;
+    }
+}
+
+
+/* DCE code. Must scan the entire live-out data.
+   Can be used also to check the correctness of the output. */
+static
+void print_array(int ni,
+		 DATA_TYPE POLYBENCH_2D(B,NI,NI,ni,ni))
+{
+  int i, j;
+
+  for (i = 0; i < ni; i++)
+    for (j = 0; j < ni; j++) {
+	fprintf (stderr, DATA_PRINTF_MODIFIER, B[i][j]);
+	if ((i * ni + j) % 20 == 0) fprintf (stderr, "\n");
+    }
+  fprintf (stderr, "\n");
+}
+
+
+/* Diagonal tile of tb rows from i0: row i reads the rows j <= i of the tile
+   updated, and the rows j > i from b0, saved before any task of the
+   tile row. */
+static
+void trmm_diagonal(int ni, int i0, int tb,
+		   const DATA_TYPE* ap, const DATA_TYPE* b0,
+		   DATA_TYPE POLYBENCH_2D(B,NI,NI,ni,ni))
+{
+  int i1 = i0 + tb < _PB_NI ? i0 + tb : _PB_NI;
+  int i, j, k;
+
+  for (i = i0; i < i1; i++)
+    for (j = i0; j < i1; j++)
+      {
+	const DATA_TYPE* a = ap + (size_t) (i - i0) / TRMM_MR * i1 * TRMM_MR + (i - i0) % TRMM_MR;
+	const DATA_TYPE* x = j <= i ? B[j] : b0 + (size_t) (j - i0) * i1;
+	DATA_TYPE s = B[i][j];
+	for (k = 0; k < i; k++)
+	  s += a[k * TRMM_MR] * x[k];
+	B[i][j] = s;
+      }
+}
+
+
+/* Main computational kernel. The whole function will be timed,
+   including the call and return. */
+static
+void kernel_trmm(int ni, int tb,
+		 DATA_TYPE alpha,
+		 DATA_TYPE POLYBENCH_2D(A,NI,NI,ni,ni),
+		 DATA_TYPE POLYBENCH_2D(B,NI,NI,ni,ni))
+{
+  int nt = (ni + tb - 1) / tb;
+  /* Per tile row: packed panel of A and its rows of B before their
+     update (see trmm_pack.h). The dependencies are on the elements of
+     tiles, packed and saved. */
+  DATA_TYPE** ap = (DATA_TYPE**) polybench_alloc_data (2 * nt, sizeof(DATA_TYPE*));
+  DATA_TYPE** b0 = ap + nt;
+  char* tiles = (char*) polybench_alloc_data ((size_t) nt * nt + 2 * nt, 1);
+  char* packed = tiles + (size_t) nt * nt;
+  char* saved = packed + nt;
+  int ti, tj, k;
+
+  /* Only named in depend clauses, which GCC does not count as uses. */
+  (void) saved;
+
+  for (ti = 0; ti < nt; ti++)
+    {
+      int i0 = ti * tb, i1 = i0 + tb < ni ? i0 + tb : ni;
+      ap[ti] = (DATA_TYPE*) polybench_alloc_data ((size_t) (i1 - i0 + TRMM_MR - 1) / TRMM_MR * TRMM_MR * i1, sizeof(DATA_TYPE));
+      b0[ti] = (DATA_TYPE*) polybench_alloc_data ((size_t) (i1 - i0) * i1, sizeof(DATA_TYPE));
+    }
+
+  #pragma scop
+  #pragma omp parallel private (ti, tj, k)
+  #pragma omp single
+  {
+    polybench_region_begin ("kernel_trmm");
+    /*  B := alpha*A'*B, A triangular, as a task per tile of B. The tasks
+	are created in the order of the sequential loop, so that the
+	in/inout dependencies give the tile (ti,tj) the rows tj < ti
+	updated and the rows tj > ti before their update: the tile rows
+	overlap as far as the data flow allows. Task ids for the trace:
+	ti (pack), nt + ti (save), 2 nt + ti nt + tj (tile). The edges of
+	the trace are the flow dependencies (the reads of updated tiles)
+	and the anti-dependencies (the updates of tiles read before). */
+    for (ti = 0; ti < nt; ti++)
+      {
+	int i0 = ti * tb, i1 = i0 + tb < _PB_NI ? i0 + tb : _PB_NI;
+
+	#pragma omp task firstprivate (ti, i0, i1) depend (out: packed[ti])
+	{
+	  int p;
+	  polybench_task_begin ("pack", ti);
+	  for (p = 0; p < (i1 - i0 + TRMM_MR - 1) / TRMM_MR; p++)
+	    trmm_pack_a (ni, i0, i1, p, alpha, A, ap[ti]);
+	  polybench_task_end ("pack", ti);
+	}
+
+	#pragma omp task firstprivate (ti, i0, i1) \
+	  depend (iterator (t = 0:ti + 1), in: tiles[(size_t) ti * nt + t]) \
+	  depend (out: saved[ti])
+	{
+	  int i;
+	  polybench_task_begin ("save", nt + ti);
+	  for (i = i0; i < i1; i++)
+	    memcpy (b0[ti] + (size_t) (i - i0) * i1, B[i], i1 * sizeof(DATA_TYPE));
+	  polybench_task_end ("save", nt + ti);
+	}
+
+	for (tj = 0; tj < nt; tj++)
+	  {
+	    long long id = 2LL * nt + (long long) ti * nt + tj;
+
+	    if (tj == ti)
+	      continue;
+	    polybench_task_edge (ti, id);
+	    if (tj < ti)
+	      {
+		for (k = 0; k <= ti; k++)
+		  polybench_task_edge (2LL * nt + (long long) tj * nt + k, id);
+		/* Tile (ti,tj) was read before its update by the save of
+		   tile row ti, and by the tiles (k,ti), tj <= k < ti. */
+		polybench_task_edge (nt + ti, id);
+		for (k = tj; k < ti; k++)
+		  polybench_task_edge (2LL * nt + (long long) k * nt + ti, id);
+	      }
+	    #pragma omp task firstprivate (ti, tj, i0, i1, id) \
+	      depend (in: packed[ti]) \
+	      depend (iterator (t = 0:ti + 1), in: tiles[(size_t) tj * nt + t]) \
+	      depend (inout: tiles[(size_t) ti * nt + tj])
+	    {
+	      DATA_TYPE bp[TRMM_NB / TRMM_NR][TRMM_KB][TRMM_NR] __attribute__((aligned (64)));
+	      int j0, j1 = tj * tb + tb < _PB_NI ? tj * tb + tb : _PB_NI;
+
+	      polybench_task_begin ("tile", id);
+	      for (j0 = tj * tb; j0 < j1; j0 += TRMM_NB)
+		trmm_update_block (ni, i0, i1, j0,
+				   j0 + TRMM_NB < j1 ? j0 + TRMM_NB : j1,
+				   ap[ti], B, bp);
+	      polybench_task_end ("tile", id);
+	    }
+	  }
+
+	{
+	  long long id = 2LL * nt + (long long) ti * nt + ti;
+
+	  polybench_task_edge (ti, id);
+	  polybench_task_edge (nt + ti, id);
+	  for (k = 0; k < ti; k++)
+	    polybench_task_edge (2LL * nt + (long long) ti * nt + k, id);
+	  #pragma omp task firstprivate (ti, i0, i1, id) \
+	    depend (in: packed[ti], saved[ti]) \
+	    depend (iterator (t = 0:ti), in: tiles[(size_t) ti * nt + t]) \
+	    depend (inout: tiles[(size_t) ti * nt + ti])
+	  {
+	    polybench_task_begin ("diagonal", id);
+	    trmm_diagonal (ni, i0, tb, ap[ti], b0[ti], B);
+	    polybench_task_end ("diagonal", id);
+	  }
+	}
+      }
+    #pragma omp taskwait
+    polybench_region_end ("kernel_trmm");
+  }
+  #pragma endscop
+
+  for (ti = 0; ti < nt; ti++)
+    {
+      polybench_free_data (ap[ti]);
+      polybench_free_data (b0[ti]);
+    }
+  polybench_free_data (ap);
+  polybench_free_data (tiles);
+}
+
+
+int main(int argc, char** argv)
+{
+  /* Retrieve problem size. */
+  int ni = POLYBENCH_SIZE(NI);
+  const char* tile = getenv ("TRMM_TILE");
+  int tb = tile && atoi (tile) > 0 ? atoi (tile) : TRMM_MB;
+
+  /* Tiles of TRMM_TILE x TRMM_TILE elements of B, a multiple of the
+     packed panels. */
+  if (tb > ni)
+    tb = ni;
+  tb = (tb + TRMM_NB - 1) / TRMM_NB * TRMM_NB;
+
+  /* Flops and compulsory memory traffic, for the GFLOP/s and roofline
+     reports. */
+  polybench_set_program_flops (3.0 * ni * ni * (ni - 1) / 2);
+  polybench_set_program_bytes (3.0 * ni * ni * sizeof(DATA_TYPE));
+
+  /* Variable declaration/allocation. */
+  DATA_TYPE alpha;
+  POLYBENCH_2D_ARRAY_DECL(A,DATA_TYPE,NI,NI,ni,ni);
+  POLYBENCH_2D_ARRAY_DECL(B,DATA_TYPE,NI,NI,ni,ni);
+
+  /* Run the kernel once per repetition (see polybench.h). */
+  polybench_repeat
+    {
+      /* Initialize array(s). */
+      init_array (ni, &alpha, POLYBENCH_ARRAY(A), POLYBENCH_ARRAY(B));
+
+      /* Start timer. */
+      polybench_start_instruments;
+
+      /* Run kernel. */
+      kernel_trmm (ni, tb, alpha, POLYBENCH_ARRAY(A), POLYBENCH_ARRAY(B));
+
+      /* Stop timer. */
+      polybench_stop_instruments;
+    }
+  /* Print timer. */
+  polybench_print_instruments;
+
+  /* Prevent dead-code elimination. All live-out data must be printed
+     by the function call in argument. */
+  polybench_prevent_dce(print_array(ni, POLYBENCH_ARRAY(B)));
+
+  /* Check the output, as selected with POLYBENCH_VERIFY. */
+  polybench_verify_2d (B, ni, ni);
+
+  /* Be clean. */
+  POLYBENCH_FREE_ARRAY(A);
+  POLYBENCH_FREE_ARRAY(B);
+
+  return 0;
+}
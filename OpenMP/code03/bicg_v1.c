@@ -75,10 +75,11 @@ void kernel_bicg(int nx, int ny,
   #pragma scop
   #pragma omp parallel
   {
-    #pragma omp for
+    polybench_region_begin ("kernel_bicg");
+    #pragma omp for POLYBENCH_SCHEDULE_DEFAULT
     for (i = 0; i < _PB_NY; i++)
       s[i] = 0;
-    #pragma omp for private (j)
+    #pragma omp for private (j) POLYBENCH_SCHEDULE_DEFAULT
     for (i = 0; i < _PB_NX; i++)
       {
         q[i] = 0;
@@ -88,6 +89,7 @@ void kernel_bicg(int nx, int ny,
 	    q[i] = q[i] + A[i][j] * p[j];
 	  }
       }
+    polybench_region_end ("kernel_bicg");
   }
   #pragma endscop
 }
@@ -96,8 +98,14 @@ void kernel_bicg(int nx, int ny,
 int main(int argc, char** argv)
 {
   /* Retrieve problem size. */
-  int nx = NX;
-  int ny = NY;
+  int nx = POLYBENCH_SIZE(NX);
+  int ny = POLYBENCH_SIZE(NY);
+
+  /* Flops and compulsory memory traffic, for the GFLOP/s and roofline
+     reports. */
+  polybench_set_program_flops (4.0 * nx * ny);
+  polybench_set_program_bytes (((double) nx * ny + 2.0 * nx + 2.0 * ny)
+			       * sizeof(DATA_TYPE));
 
   /* Variable declaration/allocation. */
   POLYBENCH_2D_ARRAY_DECL(A, DATA_TYPE, NX, NY, nx, ny);
@@ -106,31 +114,40 @@ int main(int argc, char** argv)
   POLYBENCH_1D_ARRAY_DECL(p, DATA_TYPE, NY, ny);
   POLYBENCH_1D_ARRAY_DECL(r, DATA_TYPE, NX, nx);
 
-  /* Initialize array(s). */
-  init_array (nx, ny,
-	      POLYBENCH_ARRAY(A),
-	      POLYBENCH_ARRAY(r),
-	      POLYBENCH_ARRAY(p));
-
-  /* Start timer. */
-  polybench_start_instruments;
-
-  /* Run kernel. */
-  kernel_bicg (nx, ny,
-	       POLYBENCH_ARRAY(A),
-	       POLYBENCH_ARRAY(s),
-	       POLYBENCH_ARRAY(q),
-	       POLYBENCH_ARRAY(p),
-	       POLYBENCH_ARRAY(r));
-
-  /* Stop and print timer. */
-  polybench_stop_instruments;
+  /* Run the kernel once per repetition (see polybench.h). */
+  polybench_repeat
+    {
+      /* Initialize array(s). */
+      init_array (nx, ny,
+		  POLYBENCH_ARRAY(A),
+		  POLYBENCH_ARRAY(r),
+		  POLYBENCH_ARRAY(p));
+
+      /* Start timer. */
+      polybench_start_instruments;
+
+      /* Run kernel. */
+      kernel_bicg (nx, ny,
+		   POLYBENCH_ARRAY(A),
+		   POLYBENCH_ARRAY(s),
+		   POLYBENCH_ARRAY(q),
+		   POLYBENCH_ARRAY(p),
+		   POLYBENCH_ARRAY(r));
+
+      /* Stop timer. */
+      polybench_stop_instruments;
+    }
+  /* Print timer. */
   polybench_print_instruments;
 
   /* Prevent dead-code elimination. All live-out data must be printed
      by the function call in argument. */
   polybench_prevent_dce(print_array(nx, ny, POLYBENCH_ARRAY(s), POLYBENCH_ARRAY(q)));
 
+  /* Check the output, as selected with POLYBENCH_VERIFY. */
+  polybench_verify_1d (s, ny);
+  polybench_verify_1d (q, nx);
+
   /* Be clean. */
   POLYBENCH_FREE_ARRAY(A);
   POLYBENCH_FREE_ARRAY(s);
@@ -42,6 +42,19 @@
 #  endif
 # endif /* !N */
 
+/* Dataset name, reported in the run records. */
+# if defined(MINI_DATASET)
+#  define POLYBENCH_DATASET "MINI"
+# elif defined(SMALL_DATASET)
+#  define POLYBENCH_DATASET "SMALL"
+# elif defined(LARGE_DATASET)
+#  define POLYBENCH_DATASET "LARGE"
+# elif defined(EXTRALARGE_DATASET)
+#  define POLYBENCH_DATASET "EXTRALARGE"
+# else
+#  define POLYBENCH_DATASET "STANDARD"
+# endif
+
 # define _PB_TSTEPS POLYBENCH_LOOP_BOUND(TSTEPS,tsteps)
 # define _PB_N POLYBENCH_LOOP_BOUND(N,n)
 
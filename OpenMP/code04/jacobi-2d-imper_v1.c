@@ -69,6 +69,7 @@ void kernel_jacobi_2d_imper(int tsteps,
   
   #pragma omp parallel private(i,j,t)
   {
+    polybench_region_begin ("kernel_jacobi_2d_imper");
 //    #pragma omp single
 //    {
       for (t = 0; t < _PB_TSTEPS; t++)
@@ -83,6 +84,7 @@ void kernel_jacobi_2d_imper(int tsteps,
           for (j = 1; j < _PB_N-1; j++)
             A[i][j] = B[i][j];
       }
+    polybench_region_end ("kernel_jacobi_2d_imper");
     }
 //  }
   #pragma endscop
@@ -92,31 +94,44 @@ void kernel_jacobi_2d_imper(int tsteps,
 int main(int argc, char** argv)
 {
   /* Retrieve problem size. */
-  int n = N;
-  int tsteps = TSTEPS;
+  int n = POLYBENCH_SIZE(N);
+  int tsteps = POLYBENCH_PARAM(TSTEPS);
+
+  /* Flops and compulsory memory traffic, for the GFLOP/s and roofline
+     reports. */
+  polybench_set_program_flops (5.0 * tsteps * (n - 2) * (n - 2));
+  polybench_set_program_bytes (4.0 * tsteps * n * n * sizeof(DATA_TYPE));
 
   /* Variable declaration/allocation. */
   POLYBENCH_2D_ARRAY_DECL(A, DATA_TYPE, N, N, n, n);
   POLYBENCH_2D_ARRAY_DECL(B, DATA_TYPE, N, N, n, n);
 
 
-  /* Initialize array(s). */
-  init_array (n, POLYBENCH_ARRAY(A), POLYBENCH_ARRAY(B));
+  /* Run the kernel once per repetition (see polybench.h). */
+  polybench_repeat
+    {
+      /* Initialize array(s). */
+      init_array (n, POLYBENCH_ARRAY(A), POLYBENCH_ARRAY(B));
 
-  /* Start timer. */
-  polybench_start_instruments;
+      /* Start timer. */
+      polybench_start_instruments;
 
-  /* Run kernel. */
-  kernel_jacobi_2d_imper (tsteps, n, POLYBENCH_ARRAY(A), POLYBENCH_ARRAY(B));
+      /* Run kernel. */
+      kernel_jacobi_2d_imper (tsteps, n, POLYBENCH_ARRAY(A), POLYBENCH_ARRAY(B));
 
-  /* Stop and print timer. */
-  polybench_stop_instruments;
+      /* Stop timer. */
+      polybench_stop_instruments;
+    }
+  /* Print timer. */
   polybench_print_instruments;
 
   /* Prevent dead-code elimination. All live-out data must be printed
      by the function call in argument. */
   polybench_prevent_dce(print_array(n, POLYBENCH_ARRAY(A)));
 
+  /* Check the output, as selected with POLYBENCH_VERIFY. */
+  polybench_verify_2d (A, n, n);
+
   /* Be clean. */
   POLYBENCH_FREE_ARRAY(A);
   POLYBENCH_FREE_ARRAY(B);
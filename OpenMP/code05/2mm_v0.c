@@ -25,7 +25,7 @@ static
 void init_array(int ni, int nj, int nk, int nl,
 		DATA_TYPE *alpha,
 		DATA_TYPE *beta,
-		DATA_TYPE POLYBENCH_2D(A,NI,NK,ni,nl),
+		DATA_TYPE POLYBENCH_2D(A,NI,NK,ni,nk),
 		DATA_TYPE POLYBENCH_2D(B,NK,NJ,nk,nj),
 		DATA_TYPE POLYBENCH_2D(C,NL,NJ,nl,nj),
 		DATA_TYPE POLYBENCH_2D(D,NI,NL,ni,nl))
@@ -83,7 +83,8 @@ void kernel_2mm(int ni, int nj, int nk, int nl,
   /* D := alpha*A*B*C + beta*D */
   #pragma omp parallel
   {
-    #pragma omp for private (j, k)
+    polybench_region_begin ("kernel_2mm");
+    #pragma omp for private (j, k) POLYBENCH_SCHEDULE_DEFAULT
     for (i = 0; i < _PB_NI; i++)
       for (j = 0; j < _PB_NJ; j++)
   	{
@@ -91,7 +92,7 @@ void kernel_2mm(int ni, int nj, int nk, int nl,
   	  for (k = 0; k < _PB_NK; ++k)
 	    tmp[i][j] += alpha * A[i][k] * B[k][j];
         }
-    #pragma omp for private (j, k)
+    #pragma omp for private (j, k) POLYBENCH_SCHEDULE_DEFAULT
     for (i = 0; i < _PB_NI; i++)
       for (j = 0; j < _PB_NL; j++)
         {
@@ -99,6 +100,7 @@ void kernel_2mm(int ni, int nj, int nk, int nl,
 	  for (k = 0; k < _PB_NJ; ++k)
 	    D[i][j] += tmp[i][k] * C[k][j];
 	}
+    polybench_region_end ("kernel_2mm");
   }
   #pragma endscop
 }
@@ -107,10 +109,18 @@ void kernel_2mm(int ni, int nj, int nk, int nl,
 int main(int argc, char** argv)
 {
   /* Retrieve problem size. */
-  int ni = NI;
-  int nj = NJ;
-  int nk = NK;
-  int nl = NL;
+  int ni = POLYBENCH_SIZE(NI);
+  int nj = POLYBENCH_SIZE(NJ);
+  int nk = POLYBENCH_SIZE(NK);
+  int nl = POLYBENCH_SIZE(NL);
+
+  /* Flops and compulsory memory traffic, for the GFLOP/s and roofline
+     reports. */
+  polybench_set_program_flops (3.0 * ni * nj * nk + 2.0 * ni * nl * nj
+			       + (double) ni * nl);
+  polybench_set_program_bytes (((double) ni * nk + (double) nk * nj
+				+ (double) nl * nj + 2.0 * ni * nl
+				+ (double) ni * nj) * sizeof(DATA_TYPE));
 
   /* Variable declaration/allocation. */
   DATA_TYPE alpha;
@@ -121,33 +131,41 @@ int main(int argc, char** argv)
   POLYBENCH_2D_ARRAY_DECL(C,DATA_TYPE,NL,NJ,nl,nj);
   POLYBENCH_2D_ARRAY_DECL(D,DATA_TYPE,NI,NL,ni,nl);
 
-  /* Initialize array(s). */
-  init_array (ni, nj, nk, nl, &alpha, &beta,
-	      POLYBENCH_ARRAY(A),
-	      POLYBENCH_ARRAY(B),
-	      POLYBENCH_ARRAY(C),
-	      POLYBENCH_ARRAY(D));
-
-  /* Start timer. */
-  polybench_start_instruments;
-
-  /* Run kernel. */
-  kernel_2mm (ni, nj, nk, nl,
-	      alpha, beta,
-	      POLYBENCH_ARRAY(tmp),
-	      POLYBENCH_ARRAY(A),
-	      POLYBENCH_ARRAY(B),
-	      POLYBENCH_ARRAY(C),
-	      POLYBENCH_ARRAY(D));
-
-  /* Stop and print timer. */
-  polybench_stop_instruments;
+  /* Run the kernel once per repetition (see polybench.h). */
+  polybench_repeat
+    {
+      /* Initialize array(s). */
+      init_array (ni, nj, nk, nl, &alpha, &beta,
+		  POLYBENCH_ARRAY(A),
+		  POLYBENCH_ARRAY(B),
+		  POLYBENCH_ARRAY(C),
+		  POLYBENCH_ARRAY(D));
+
+      /* Start timer. */
+      polybench_start_instruments;
+
+      /* Run kernel. */
+      kernel_2mm (ni, nj, nk, nl,
+		  alpha, beta,
+		  POLYBENCH_ARRAY(tmp),
+		  POLYBENCH_ARRAY(A),
+		  POLYBENCH_ARRAY(B),
+		  POLYBENCH_ARRAY(C),
+		  POLYBENCH_ARRAY(D));
+
+      /* Stop timer. */
+      polybench_stop_instruments;
+    }
+  /* Print timer. */
   polybench_print_instruments;
 
   /* Prevent dead-code elimination. All live-out data must be printed
      by the function call in argument. */
   polybench_prevent_dce(print_array(ni, nl,  POLYBENCH_ARRAY(D)));
 
+  /* Check the output, as selected with POLYBENCH_VERIFY. */
+  polybench_verify_2d (D, ni, nl);
+
   /* Be clean. */
   POLYBENCH_FREE_ARRAY(tmp);
   POLYBENCH_FREE_ARRAY(A);
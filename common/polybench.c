@@ -5,8 +5,13 @@
  * Contact: Louis-Noel Pouchet <pouchet@cse.ohio-state.edu>
  * Web address: http://polybench.sourceforge.net
  */
+/* For sched_getcpu and program_invocation_short_name. */
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE
+#endif
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <assert.h>
@@ -15,6 +20,14 @@
 #include <sys/resource.h>
 #include <sched.h>
 #include <math.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#ifdef __linux__
+# include <sys/mman.h>
+# include <sys/syscall.h>
+# include <pthread.h>
+#endif
 #ifdef _OPENMP
 # include <omp.h>
 #endif
@@ -24,7 +37,13 @@
 # define POLYBENCH_THREAD_MONITOR 0
 #endif
 
-/* Total LLC cache size. By default 32+MB.. */
+/* Maximal number of threads monitored by the counter backends. */
+#ifndef POLYBENCH_MAX_NB_THREADS
+# define POLYBENCH_MAX_NB_THREADS 256
+#endif
+
+/* Total LLC cache size, when it cannot be read from sysfs. By default
+   32+MB.. */
 #ifndef POLYBENCH_CACHE_SIZE_KB
 # define POLYBENCH_CACHE_SIZE_KB 32770
 #endif
@@ -32,6 +51,7 @@
 
 int polybench_papi_counters_threadid = POLYBENCH_THREAD_MONITOR;
 double polybench_program_total_flops = 0;
+double polybench_program_total_bytes = 0;
 
 #ifdef POLYBENCH_PAPI
 # include <papi.h>
@@ -43,58 +63,628 @@ double polybench_program_total_flops = 0;
   int polybench_papi_eventset;
   int polybench_papi_eventlist[POLYBENCH_MAX_NB_PAPI_COUNTERS];
   long_long polybench_papi_values[POLYBENCH_MAX_NB_PAPI_COUNTERS];
+# ifndef POLYBENCH_PAPI_SERIALIZE
+  /* Grouped mode: one event set per OpenMP thread. */
+  int polybench_papi_nb_events = 0;
+  int polybench_papi_nb_threads = 1;
+  int polybench_papi_multiplexed = 0;
+  int polybench_papi_eventsets[POLYBENCH_MAX_NB_THREADS];
+  long_long polybench_papi_thread_values[POLYBENCH_MAX_NB_THREADS][POLYBENCH_MAX_NB_PAPI_COUNTERS];
+# endif
 
 #endif
 
 
-/* Timer code (gettimeofday). */
+/* Timer code (clock_gettime). */
 double polybench_t_start, polybench_t_end;
-/* Timer code (RDTSC). */
+/* Timer code (TSC, see polybench_stamp_begin). */
 unsigned long long int polybench_c_start, polybench_c_end;
 
+/* Repetition mode: samples of the timed runs, in seconds (or cycles
+   with POLYBENCH_CYCLE_ACCURATE_TIMER). */
+int polybench_nb_runs = 1;
+int polybench_nb_warmup = 0;
+int polybench_run = 0;
+double polybench_cv_threshold = 5.0;
+double* polybench_t_samples = NULL;
+
+static
+int polybench_getenv_int(const char* name, int def)
+{
+  const char* val = getenv (name);
+  if (val == NULL || *val == '\0')
+    return def;
+  return atoi (val);
+}
+
+static
+double polybench_getenv_double(const char* name, double def)
+{
+  const char* val = getenv (name);
+  if (val == NULL || *val == '\0')
+    return def;
+  return atof (val);
+}
+
+/* Problem sizes read by polybench_get_size, for the run records. */
+#define POLYBENCH_MAX_NB_SIZES 16
+int polybench_nb_sizes = 0;
+const char* polybench_size_names[POLYBENCH_MAX_NB_SIZES];
+int polybench_size_values[POLYBENCH_MAX_NB_SIZES];
+/* Array dimension for the size: the compile-time one, unless the
+   arrays are sized at run time. */
+int polybench_size_dims[POLYBENCH_MAX_NB_SIZES];
+int polybench_sizes_overridden = 0;
+
+static
+int polybench_register_size(const char* name, int def, int size, int max)
+{
+  if (polybench_nb_sizes < POLYBENCH_MAX_NB_SIZES)
+    {
+      polybench_size_names[polybench_nb_sizes] = name;
+      polybench_size_dims[polybench_nb_sizes] = max > 0 ? max : size;
+      polybench_size_values[polybench_nb_sizes++] = size;
+    }
+  if (size != def)
+    polybench_sizes_overridden = 1;
+  return size;
+}
+
+int polybench_get_size(int argc, char** argv, const char* name,
+		       int def, int max)
+{
+  char env[64];
+  const char* val = NULL;
+  size_t len = strlen (name);
+  int i, size;
+
+  for (i = 1; i < argc; i++)
+    if (! strncmp (argv[i], "--", 2)
+	&& ! strncasecmp (argv[i] + 2, name, len) && argv[i][2 + len] == '=')
+      val = argv[i] + 3 + len;
+  if (val == NULL)
+    {
+      snprintf (env, sizeof(env), "POLYBENCH_%s", name);
+      val = getenv (env);
+    }
+  if (val == NULL || *val == '\0')
+    return polybench_register_size (name, def, def, max);
+  size = atoi (val);
+  if (size <= 0 || (max > 0 && size > max))
+    {
+      fprintf (stderr, "[PolyBench] invalid size %s=%s", name, val);
+      if (max > 0)
+	fprintf (stderr, " (at most %d without POLYBENCH_USE_C99_PROTO)", max);
+      fprintf (stderr, "\n");
+      exit (1);
+    }
+  return polybench_register_size (name, def, size, max);
+}
+
+
+#if ! defined(POLYBENCH_CYCLE_ACCURATE_TIMER) || defined(POLYBENCH_ROOFLINE)
 static
 double rtclock()
 {
-#ifdef POLYBENCH_TIME
-    struct timeval Tp;
+#if defined(POLYBENCH_TIME) || defined(POLYBENCH_GFLOPS)
+    struct timespec Tp;
     int stat;
-    stat = gettimeofday (&Tp, NULL);
+# ifdef CLOCK_MONOTONIC_RAW
+    stat = clock_gettime (CLOCK_MONOTONIC_RAW, &Tp);
+# else
+    stat = clock_gettime (CLOCK_MONOTONIC, &Tp);
+# endif
     if (stat != 0)
-      printf ("Error return from gettimeofday: %d", stat);
-    return (Tp.tv_sec + Tp.tv_usec * 1.0e-6);
+      printf ("Error return from clock_gettime: %d", stat);
+    return (Tp.tv_sec + Tp.tv_nsec * 1.0e-9);
 #else
     return 0;
 #endif
 }
+#endif
 
 
-#ifdef POLYBENCH_CYCLE_ACCURATE_TIMER
+/* Time stamp counter. The reads are serialized: a begin stamp is taken
+   once the preceding instructions are done, and before the following
+   ones start (lfence; rdtsc; lfence); an end stamp waits for the
+   preceding instructions (rdtscp, or lfence; rdtsc) and holds the
+   following ones (lfence). The TSC is used if it is invariant (constant
+   rate, running in idle states) and POLYBENCH_TSC is not 0; it is then
+   calibrated against CLOCK_MONOTONIC_RAW to convert the ticks to
+   nanoseconds. Otherwise, the stamps are read from CLOCK_MONOTONIC_RAW,
+   in nanoseconds. */
+#if defined(__x86_64__) || defined(__i386__)
+# include <x86intrin.h>
+# include <cpuid.h>
+# define POLYBENCH_HAS_TSC
+#endif
+#ifndef CLOCK_MONOTONIC_RAW
+# define CLOCK_MONOTONIC_RAW CLOCK_MONOTONIC
+#endif
+
+int polybench_tsc = -1;
+int polybench_tsc_rdtscp = 0;
+/* Ticks per nanosecond, 0 until calibrated. */
+double polybench_tsc_ghz = 0;
+
+
+static inline
+unsigned long long polybench_clock_ns()
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC_RAW, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+static inline
+unsigned long long polybench_stamp_begin()
+{
+#ifdef POLYBENCH_HAS_TSC
+  if (polybench_tsc > 0)
+    {
+      unsigned long long t;
+      _mm_lfence ();
+      t = __rdtsc ();
+      _mm_lfence ();
+      return t;
+    }
+#endif
+  return polybench_clock_ns ();
+}
+
+
+static inline
+unsigned long long polybench_stamp_end()
+{
+#ifdef POLYBENCH_HAS_TSC
+  if (polybench_tsc > 0)
+    {
+      unsigned long long t;
+      unsigned int aux;
+      if (polybench_tsc_rdtscp)
+	t = __rdtscp (&aux);
+      else
+	{
+	  _mm_lfence ();
+	  t = __rdtsc ();
+	}
+      _mm_lfence ();
+      return t;
+    }
+#endif
+  return polybench_clock_ns ();
+}
+
+
+static
+void polybench_tsc_init()
+{
+  if (polybench_tsc >= 0)
+    return;
+  polybench_tsc = 0;
+  polybench_tsc_ghz = 1;
+#ifdef POLYBENCH_HAS_TSC
+  {
+    unsigned int eax, ebx, ecx, edx;
+    if (! polybench_getenv_int ("POLYBENCH_TSC", 1))
+      return;
+    if (__get_cpuid (0x80000001, &eax, &ebx, &ecx, &edx))
+      polybench_tsc_rdtscp = (edx >> 27) & 1;
+    if (__get_cpuid (0x80000007, &eax, &ebx, &ecx, &edx) && (edx >> 8) & 1)
+      {
+	polybench_tsc = 1;
+	polybench_tsc_ghz = 0;
+	return;
+      }
+  }
+  fprintf (stderr, "[PolyBench][WARNING] the TSC is not invariant, "
+	   "using CLOCK_MONOTONIC_RAW\n");
+#endif
+}
+
+
+/* Ticks per nanosecond, measured over POLYBENCH_TSC_CALIBRATION_MS
+   (default: 10) milliseconds. Done once, outside of the timed runs. */
+static
+double polybench_tsc_calibrate()
+{
+  unsigned long long ns0, ns1, t0, t1;
+  unsigned long long len;
+
+  polybench_tsc_init ();
+  if (polybench_tsc_ghz > 0)
+    return polybench_tsc_ghz;
+  len = 1000000ULL * polybench_getenv_int ("POLYBENCH_TSC_CALIBRATION_MS", 10);
+  ns0 = polybench_clock_ns ();
+  t0 = polybench_stamp_begin ();
+  do
+    ns1 = polybench_clock_ns ();
+  while (ns1 - ns0 < len);
+  t1 = polybench_stamp_end ();
+  ns1 = polybench_clock_ns ();
+  polybench_tsc_ghz = (double) (t1 - t0) / (ns1 - ns0);
+  return polybench_tsc_ghz;
+}
+
+
+/* Per-thread stamps, taken by polybench_thread_begin/end inside a
+   parallel region: around a "omp for nowait" loop, the end stamps give
+   the arrival of the threads at the following barrier. The stamps of
+   the last timed run are reported on stderr with POLYBENCH_STAMPS=1,
+   with the arrival skew (latest minus earliest end stamp) of all the
+   timed runs. */
+struct polybench_thread_stamps
+{
+  unsigned long long begin;
+  unsigned long long end;
+} __attribute__ ((aligned (64)));
+
+struct polybench_thread_stamps polybench_stamps[POLYBENCH_MAX_NB_THREADS];
+int polybench_stamps_nb_threads = 0;
+int polybench_stamps_nb_runs = 0;
+double polybench_stamps_skew_sum = 0;
+double polybench_stamps_skew_max = 0;
+
+
+void polybench_thread_stamp(int end)
+{
+  int tid = 0, nb_threads = 1;
+#ifdef _OPENMP
+  tid = omp_get_thread_num ();
+  nb_threads = omp_get_num_threads ();
+#endif
+  if (tid >= POLYBENCH_MAX_NB_THREADS)
+    return;
+  if (end)
+    polybench_stamps[tid].end = polybench_stamp_end ();
+  else
+    polybench_stamps[tid].begin = polybench_stamp_begin ();
+  if (tid == 0)
+    polybench_stamps_nb_threads = nb_threads < POLYBENCH_MAX_NB_THREADS
+      ? nb_threads : POLYBENCH_MAX_NB_THREADS;
+}
+
+
+static
+void polybench_stamps_collect()
+{
+  unsigned long long lo = ~0ULL, hi = 0;
+  int tid;
+
+  if (polybench_stamps_nb_threads == 0)
+    return;
+  for (tid = 0; tid < polybench_stamps_nb_threads; tid++)
+    {
+      if (polybench_stamps[tid].end < lo)
+	lo = polybench_stamps[tid].end;
+      if (polybench_stamps[tid].end > hi)
+	hi = polybench_stamps[tid].end;
+    }
+  polybench_stamps_skew_sum += hi - lo;
+  if (hi - lo > polybench_stamps_skew_max)
+    polybench_stamps_skew_max = hi - lo;
+  polybench_stamps_nb_runs++;
+}
+
+
+static
+void polybench_stamps_print()
+{
+  unsigned long long first = ~0ULL, last = 0;
+  double ghz;
+  int tid;
+
+  if (polybench_stamps_nb_runs == 0
+      || ! polybench_getenv_int ("POLYBENCH_STAMPS", 0))
+    return;
+  ghz = polybench_tsc_calibrate ();
+  for (tid = 0; tid < polybench_stamps_nb_threads; tid++)
+    {
+      if (polybench_stamps[tid].begin < first)
+	first = polybench_stamps[tid].begin;
+      if (polybench_stamps[tid].end > last)
+	last = polybench_stamps[tid].end;
+    }
+  for (tid = 0; tid < polybench_stamps_nb_threads; tid++)
+    fprintf (stderr, "[PolyBench] thread %d: begin=+%0.0f ns "
+	     "end=+%0.0f ns wait=%0.0f ns\n", tid,
+	     (polybench_stamps[tid].begin - first) / ghz,
+	     (polybench_stamps[tid].end - first) / ghz,
+	     (last - polybench_stamps[tid].end) / ghz);
+  fprintf (stderr, "[PolyBench] arrival skew: mean=%0.0f ns max=%0.0f ns "
+	   "over %d runs\n",
+	   polybench_stamps_skew_sum / polybench_stamps_nb_runs / ghz,
+	   polybench_stamps_skew_max / ghz, polybench_stamps_nb_runs);
+}
+
+/* Cache flushing. The flush buffer is sized from the cache hierarchy
+   found in /sys/devices/system/cpu (POLYBENCH_CACHE_SIZE_KB, from the
+   environment or at compile time, overrides the LLC size), allocated
+   once and pre-faulted. Each OpenMP thread reads its own chunk, large
+   enough to evict its private caches, and together the chunks cover
+   twice the shared LLCs. POLYBENCH_CACHE=warm disables the flush, to
+   time warm-cache runs (combine with POLYBENCH_WARMUP). */
+double* polybench_flush_buffer = NULL;
+size_t polybench_flush_chunk = 0;
+int polybench_flush_nb_threads = 0;
+volatile double polybench_flush_sink;
+
+
+static
+int polybench_read_sysfs(const char* path, char* buf, int len)
+{
+  FILE* f = fopen (path, "r");
+  int ok;
+  if (! f)
+    return 0;
+  ok = fgets (buf, len, f) != NULL;
+  fclose (f);
+  if (ok)
+    buf[strcspn (buf, "\n")] = '\0';
+  return ok;
+}
+
+
+/* Return the size, in bytes, of the private data caches of a core and
+   of all the instances of the last-level cache. */
 static
-unsigned long long int rdtsc()
+void polybench_cache_topology(size_t* private_size, size_t* llc_size)
 {
-  unsigned long long int ret = 0;
-  unsigned int cycles_lo;
-  unsigned int cycles_hi;
-  __asm__ volatile ("RDTSC" : "=a" (cycles_lo), "=d" (cycles_hi));
-  ret = (unsigned long long int)cycles_hi << 32 | cycles_lo;
+#define POLYBENCH_MAX_NB_LLC 256
+  static char llc_shared[POLYBENCH_MAX_NB_LLC][256];
+  char path[256], buf[256];
+  int nb_llc = 0, max_level = 0, first_cpu = -1;
+  int nb_cpus = sysconf (_SC_NPROCESSORS_CONF);
+  int pass, cpu, idx, k;
 
-  return ret;
+  *private_size = 0;
+  *llc_size = 0;
+  /* First pass finds the last level, second pass sums the sizes.
+     Offline CPUs have no cache directory and are skipped, so that the
+     LLCs of the CPUs after them are still counted. */
+  for (pass = 0; pass < 2; pass++)
+    for (cpu = 0; cpu < nb_cpus; cpu++)
+      {
+	sprintf (path, "/sys/devices/system/cpu/cpu%d/cache", cpu);
+	if (access (path, F_OK))
+	  continue;
+	if (first_cpu < 0)
+	  first_cpu = cpu;
+	for (idx = 0; ; idx++)
+	  {
+	    int level;
+	    size_t size;
+	    char* unit;
+	    sprintf (path, "/sys/devices/system/cpu/cpu%d/cache/index%d/level",
+		     cpu, idx);
+	    if (! polybench_read_sysfs (path, buf, sizeof(buf)))
+	      break;
+	    level = atoi (buf);
+	    sprintf (path, "/sys/devices/system/cpu/cpu%d/cache/index%d/type",
+		     cpu, idx);
+	    if (polybench_read_sysfs (path, buf, sizeof(buf))
+		&& ! strcmp (buf, "Instruction"))
+	      continue;
+	    if (pass == 0)
+	      {
+		max_level = level > max_level ? level : max_level;
+		continue;
+	      }
+	    sprintf (path, "/sys/devices/system/cpu/cpu%d/cache/index%d/size",
+		     cpu, idx);
+	    if (! polybench_read_sysfs (path, buf, sizeof(buf)))
+	      continue;
+	    size = strtoul (buf, &unit, 10);
+	    size *= *unit == 'M' ? 1024 * 1024 : *unit == 'K' ? 1024 : 1;
+	    if (level < max_level)
+	      {
+		if (cpu == first_cpu)
+		  *private_size += size;
+		continue;
+	      }
+	    /* Count each LLC instance once, by its set of CPUs. */
+	    sprintf (path, "/sys/devices/system/cpu/cpu%d/cache/index%d/"
+		     "shared_cpu_list", cpu, idx);
+	    if (! polybench_read_sysfs (path, buf, sizeof(buf)))
+	      sprintf (buf, "%d", cpu);
+	    for (k = 0; k < nb_llc; k++)
+	      if (! strcmp (llc_shared[k], buf))
+		break;
+	    if (k == nb_llc && nb_llc < POLYBENCH_MAX_NB_LLC)
+	      {
+		strcpy (llc_shared[nb_llc++], buf);
+		*llc_size += size;
+	      }
+	  }
+      }
+  if (max_level <= 1)
+    *private_size = 0;
+}
+
+
+static
+void polybench_free_flush_buffer()
+{
+  free (polybench_flush_buffer);
+  polybench_flush_buffer = NULL;
 }
+
+
+static
+void polybench_alloc_flush_buffer(int nb_threads)
+{
+  size_t private_size, llc_size, chunk;
+  int kb;
+
+  polybench_cache_topology (&private_size, &llc_size);
+  kb = polybench_getenv_int ("POLYBENCH_CACHE_SIZE_KB", 0);
+  if (kb > 0)
+    llc_size = (size_t) kb * 1024;
+  else if (llc_size == 0)
+    llc_size = (size_t) POLYBENCH_CACHE_SIZE_KB * 1024;
+  chunk = 2 * llc_size / nb_threads;
+  if (chunk < 2 * private_size)
+    chunk = 2 * private_size;
+  /* Whole cache lines per thread. */
+  chunk = (chunk / sizeof(double) + 7) & ~(size_t) 7;
+
+  if (polybench_flush_buffer == NULL)
+    atexit (polybench_free_flush_buffer);
+  free (polybench_flush_buffer);
+  if (posix_memalign ((void**) &polybench_flush_buffer, 64,
+		      chunk * nb_threads * sizeof(double)))
+    {
+      fprintf (stderr, "[PolyBench] cannot allocate the flush buffer\n");
+      exit (1);
+    }
+  polybench_flush_chunk = chunk;
+  polybench_flush_nb_threads = nb_threads;
+
+  /* Pre-fault every chunk from the thread that reads it. */
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nb_threads)
+  {
+    int tid = omp_get_thread_num ();
+#else
+  {
+    int tid = 0;
 #endif
+    memset (polybench_flush_buffer + tid * chunk, 0, chunk * sizeof(double));
+  }
+}
+
 
 void polybench_flush_cache()
 {
-  int cs = POLYBENCH_CACHE_SIZE_KB * 1024 / sizeof(double);
-  double* flush = (double*) calloc (cs, sizeof(double));
-  int i;
+  static int warm = -1;
+  int nb_threads = 1;
   double tmp = 0.0;
+
+  if (warm < 0)
+    {
+      const char* mode = getenv ("POLYBENCH_CACHE");
+      warm = mode && ! strcmp (mode, "warm");
+    }
+  if (warm)
+    return;
+#ifdef _OPENMP
+  nb_threads = omp_get_max_threads ();
+#endif
+  if (nb_threads != polybench_flush_nb_threads)
+    polybench_alloc_flush_buffer (nb_threads);
+
 #ifdef _OPENMP
-#pragma omp parallel for
+#pragma omp parallel num_threads(nb_threads) reduction(+:tmp)
+  {
+    int tid = omp_get_thread_num ();
+#else
+  {
+    int tid = 0;
 #endif
-  for (i = 0; i < cs; i++)
-    tmp += flush[i];
+    double* chunk = polybench_flush_buffer + tid * polybench_flush_chunk;
+    size_t i;
+    for (i = 0; i < polybench_flush_chunk; i++)
+      tmp += chunk[i];
+  }
   assert (tmp <= 10.0);
-  free (flush);
+  polybench_flush_sink = tmp;
+}
+
+
+/* Array padding, with -DPOLYBENCH_RUNTIME_PADDING. POLYBENCH_PADDING
+   gives the number of elements added to every array dimension (default:
+   0), or "auto" to add a cache line of doubles when a row of some array,
+   of floats or doubles, is a multiple of a quarter of an L1 way: the
+   column-wise accesses of such arrays then hit only a few sets. The
+   padding is decided once, after the sizes are read. */
+int polybench_padding = -1;
+
+
+static
+int polybench_gcd(int a, int b)
+{
+  while (b)
+    {
+      int t = a % b;
+      a = b;
+      b = t;
+    }
+  return a;
+}
+
+
+/* Line size, number of sets and associativity of the L1 data cache. */
+static
+int polybench_l1_geometry(int* line, int* sets, int* ways)
+{
+  char path[128], buf[64];
+  int idx;
+
+  for (idx = 0; idx < 8; idx++)
+    {
+      snprintf (path, sizeof(path),
+		"/sys/devices/system/cpu/cpu0/cache/index%d/level", idx);
+      if (! polybench_read_sysfs (path, buf, sizeof(buf)))
+	break;
+      if (atoi (buf) != 1)
+	continue;
+      snprintf (path, sizeof(path),
+		"/sys/devices/system/cpu/cpu0/cache/index%d/type", idx);
+      if (polybench_read_sysfs (path, buf, sizeof(buf))
+	  && ! strncmp (buf, "Instruction", 11))
+	continue;
+      snprintf (path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/"
+		"index%d/coherency_line_size", idx);
+      *line = polybench_read_sysfs (path, buf, sizeof(buf)) ? atoi (buf) : 0;
+      snprintf (path, sizeof(path),
+		"/sys/devices/system/cpu/cpu0/cache/index%d/number_of_sets", idx);
+      *sets = polybench_read_sysfs (path, buf, sizeof(buf)) ? atoi (buf) : 0;
+      snprintf (path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/"
+		"index%d/ways_of_associativity", idx);
+      *ways = polybench_read_sysfs (path, buf, sizeof(buf)) ? atoi (buf) : 0;
+      return *line > 0 && *sets > 0 && *ways > 0;
+    }
+  return 0;
+}
+
+
+int polybench_get_padding()
+{
+  const char* val;
+  int line = 64, sets = 64, ways = 8;
+  int i;
+  size_t e;
+
+  if (polybench_padding >= 0)
+    return polybench_padding;
+  val = getenv ("POLYBENCH_PADDING");
+  polybench_padding = 0;
+  if (val == NULL || *val == '\0')
+    return polybench_padding;
+  if (strcmp (val, "auto"))
+    {
+      polybench_padding = atoi (val);
+      if (polybench_padding < 0)
+	{
+	  fprintf (stderr, "[PolyBench] invalid POLYBENCH_PADDING=%s\n", val);
+	  exit (1);
+	}
+      return polybench_padding;
+    }
+  polybench_l1_geometry (&line, &sets, &ways);
+  for (i = 0; i < polybench_nb_sizes; i++)
+    for (e = sizeof(float); e <= sizeof(double); e *= 2)
+      {
+	long row = (long) polybench_size_dims[i] * e;
+	/* Number of sets hit by a column of the array. */
+	if (row % line == 0
+	    && sets / polybench_gcd ((row / line) % sets, sets) <= 4)
+	  polybench_padding = line / sizeof(double);
+      }
+  fprintf (stderr, "[PolyBench] padding=%d (L1: %d sets of %d ways of "
+	   "%d bytes)\n", polybench_padding, sets, ways, line);
+  return polybench_padding;
 }
 
 
@@ -118,6 +708,68 @@ void polybench_linux_standard_scheduler()
 }
 #endif
 
+#if (defined(POLYBENCH_PAPI) && ! defined(POLYBENCH_PAPI_SERIALIZE)) \
+  || defined(POLYBENCH_PERF)
+/* Derived metrics, computed when both counters are in the event list
+   (grouped PAPI and perf modes, which report per-thread counts).
+   Each counter is given by its PAPI and its perf name. The
+   per-1000-instructions ratios are the ones of the Paraver
+   configurations in common/cfgs (IPC_profile.cfg, L2missratio.cfg). */
+static struct {
+  const char* name;
+  const char* num[2];
+  const char* den[2];
+  double scale;
+} polybench_metrics[] = {
+  { "IPC", { "PAPI_TOT_INS", "instructions" },
+    { "PAPI_TOT_CYC", "cycles" }, 1.0 },
+  { "L1_DCM_per_1000_instr", { "PAPI_L1_DCM", "L1-dcache-load-misses" },
+    { "PAPI_TOT_INS", "instructions" }, 1000.0 },
+  { "L2_DCM_per_1000_instr", { "PAPI_L2_DCM", NULL },
+    { "PAPI_TOT_INS", NULL }, 1000.0 },
+  { "L3_TCM_per_1000_instr", { "PAPI_L3_TCM", "LLC-load-misses" },
+    { "PAPI_TOT_INS", "instructions" }, 1000.0 },
+  { "L1_miss_ratio", { "PAPI_L1_DCM", "L1-dcache-load-misses" },
+    { "PAPI_L1_DCA", "L1-dcache-loads" }, 1.0 },
+  { "L2_miss_ratio", { "PAPI_L2_DCM", NULL },
+    { "PAPI_L2_DCA", NULL }, 1.0 },
+  { "L3_miss_ratio", { "PAPI_L3_TCM", "LLC-load-misses" },
+    { "PAPI_L3_TCA", "LLC-loads" }, 1.0 },
+  { "cache_miss_ratio", { NULL, "cache-misses" },
+    { NULL, "cache-references" }, 1.0 },
+  { NULL, { NULL, NULL }, { NULL, NULL }, 0 }
+};
+
+
+static
+int polybench_counter_index(char** names, int nb, const char** aliases)
+{
+  int i, k;
+  for (k = 0; k < 2; ++k)
+    for (i = 0; aliases[k] && i < nb; ++i)
+      if (! strcmp (names[i], aliases[k]))
+	return i;
+  return -1;
+}
+
+
+static
+void polybench_print_metrics(char** names, int nb, long long* values)
+{
+  int k;
+  for (k = 0; polybench_metrics[k].name; ++k)
+    {
+      int num = polybench_counter_index (names, nb, polybench_metrics[k].num);
+      int den = polybench_counter_index (names, nb, polybench_metrics[k].den);
+      if (num < 0 || den < 0 || values[num] < 0 || values[den] <= 0)
+	continue;
+      printf (" %s=%0.4f", polybench_metrics[k].name,
+	      polybench_metrics[k].scale * values[num] / values[den]);
+    }
+}
+#endif
+
+
 #ifdef POLYBENCH_PAPI
 
 static
@@ -155,66 +807,238 @@ void test_fail(char *file, int line, char *call, int retval)
 }
 
 
-void polybench_papi_init()
-{
-# ifdef _OPENMP
-#pragma omp parallel
-  {
-#pragma omp master
-    {
-      if (omp_get_max_threads () < polybench_papi_counters_threadid)
-	polybench_papi_counters_threadid = omp_get_max_threads () - 1;
-    }
-#pragma omp barrier
+# ifndef POLYBENCH_PAPI_SERIALIZE
+/* Grouped mode: all the events of papi_counters.list are programmed
+   at once on every OpenMP thread, so the kernel runs only once. When
+   the events do not fit in the hardware counters together, the event
+   sets are multiplexed and PAPI scales the counts. */
 
-    if (omp_get_thread_num () == polybench_papi_counters_threadid)
-      {
+# ifdef _OPENMP
+static
+unsigned long polybench_papi_thread_id()
+{
+  return (unsigned long) omp_get_thread_num ();
+}
 # endif
-	int retval;
-	polybench_papi_eventset = PAPI_NULL;
-	if ((retval = PAPI_library_init (PAPI_VER_CURRENT)) != PAPI_VER_CURRENT)
-	  test_fail (__FILE__, __LINE__, "PAPI_library_init", retval);
-	if ((retval = PAPI_create_eventset (&polybench_papi_eventset))
-	    != PAPI_OK)
-	  test_fail (__FILE__, __LINE__, "PAPI_create_eventset", retval);
-	int k;
-	for (k = 0; _polybench_papi_eventlist[k]; ++k)
-	  {
-	    if ((retval =
-		 PAPI_event_name_to_code (_polybench_papi_eventlist[k],
-					  &(polybench_papi_eventlist[k])))
-		!= PAPI_OK)
-	      test_fail (__FILE__, __LINE__, "PAPI_event_name_to_code", retval);
-	  }
-	polybench_papi_eventlist[k] = 0;
 
 
+void polybench_papi_init()
+{
+  int retval;
+  int k;
+
+  if ((retval = PAPI_library_init (PAPI_VER_CURRENT)) != PAPI_VER_CURRENT)
+    test_fail (__FILE__, __LINE__, "PAPI_library_init", retval);
 # ifdef _OPENMP
-      }
-  }
-#pragma omp barrier
+  if ((retval = PAPI_thread_init (polybench_papi_thread_id)) != PAPI_OK)
+    test_fail (__FILE__, __LINE__, "PAPI_thread_init", retval);
 # endif
+  if ((retval = PAPI_multiplex_init ()) != PAPI_OK)
+    test_fail (__FILE__, __LINE__, "PAPI_multiplex_init", retval);
+  for (k = 0; _polybench_papi_eventlist[k]; ++k)
+    {
+      if ((retval =
+	   PAPI_event_name_to_code (_polybench_papi_eventlist[k],
+				    &(polybench_papi_eventlist[k])))
+	  != PAPI_OK)
+	test_fail (__FILE__, __LINE__, "PAPI_event_name_to_code", retval);
+    }
+  polybench_papi_eventlist[k] = 0;
+  polybench_papi_nb_events = k;
+  polybench_papi_multiplexed = 0;
 }
 
 
 void polybench_papi_close()
 {
+  if (PAPI_is_initialized ())
+    PAPI_shutdown ();
+}
+
+
+void polybench_papi_start_group()
+{
+  polybench_papi_nb_threads = 1;
 # ifdef _OPENMP
 #pragma omp parallel
   {
-    if (omp_get_thread_num () == polybench_papi_counters_threadid)
-      {
+#pragma omp master
+    polybench_papi_nb_threads = omp_get_num_threads ();
+    int tid = omp_get_thread_num ();
+# else
+    int tid = 0;
 # endif
-	int retval;
-	if ((retval = PAPI_destroy_eventset (&polybench_papi_eventset))
+    int retval;
+    int* eventset = &polybench_papi_eventsets[tid];
+
+    if (tid >= POLYBENCH_MAX_NB_THREADS)
+      test_fail (__FILE__, __LINE__, "POLYBENCH_MAX_NB_THREADS", 1);
+    if ((retval = PAPI_register_thread ()) != PAPI_OK)
+      test_fail (__FILE__, __LINE__, "PAPI_register_thread", retval);
+    *eventset = PAPI_NULL;
+    if ((retval = PAPI_create_eventset (eventset)) != PAPI_OK)
+      test_fail (__FILE__, __LINE__, "PAPI_create_eventset", retval);
+    if (PAPI_add_events (*eventset, polybench_papi_eventlist,
+			 polybench_papi_nb_events) != PAPI_OK)
+      {
+	/* The events conflict: retry with a multiplexed event set. */
+	if ((retval = PAPI_cleanup_eventset (*eventset)) != PAPI_OK)
+	  test_fail (__FILE__, __LINE__, "PAPI_cleanup_eventset", retval);
+	if ((retval = PAPI_assign_eventset_component (*eventset, 0))
 	    != PAPI_OK)
-	  test_fail (__FILE__, __LINE__, "PAPI_destroy_eventset", retval);
-	if (PAPI_is_initialized ())
-	  PAPI_shutdown ();
-# ifdef _OPENMP
+	  test_fail (__FILE__, __LINE__, "PAPI_assign_eventset_component",
+		     retval);
+	if ((retval = PAPI_set_multiplex (*eventset)) != PAPI_OK)
+	  test_fail (__FILE__, __LINE__, "PAPI_set_multiplex", retval);
+	if ((retval = PAPI_add_events (*eventset, polybench_papi_eventlist,
+				       polybench_papi_nb_events)) != PAPI_OK)
+	  test_fail (__FILE__, __LINE__, "PAPI_add_events", retval);
+	polybench_papi_multiplexed = 1;
       }
+    if ((retval = PAPI_start (*eventset)) != PAPI_OK)
+      test_fail (__FILE__, __LINE__, "PAPI_start", retval);
+# ifdef _OPENMP
   }
-#pragma omp barrier
+# endif
+}
+
+
+void polybench_papi_stop_group()
+{
+# ifdef _OPENMP
+#pragma omp parallel
+  {
+    int tid = omp_get_thread_num ();
+# else
+    int tid = 0;
+# endif
+    int retval;
+    int* eventset = &polybench_papi_eventsets[tid];
+
+    if ((retval = PAPI_stop (*eventset, polybench_papi_thread_values[tid]))
+	!= PAPI_OK)
+      test_fail (__FILE__, __LINE__, "PAPI_stop", retval);
+    if ((retval = PAPI_cleanup_eventset (*eventset)) != PAPI_OK)
+      test_fail (__FILE__, __LINE__, "PAPI_cleanup_eventset", retval);
+    if ((retval = PAPI_destroy_eventset (eventset)) != PAPI_OK)
+      test_fail (__FILE__, __LINE__, "PAPI_destroy_eventset", retval);
+    if ((retval = PAPI_unregister_thread ()) != PAPI_OK)
+      test_fail (__FILE__, __LINE__, "PAPI_unregister_thread", retval);
+# ifdef _OPENMP
+  }
+# endif
+}
+
+
+void polybench_papi_print()
+{
+  int verbose = 0;
+  int tid, evid;
+  long_long totals[POLYBENCH_MAX_NB_PAPI_COUNTERS];
+
+#ifdef POLYBENCH_PAPI_VERBOSE
+  verbose = 1;
+#endif
+  if (polybench_papi_multiplexed)
+    printf ("[PolyBench][WARNING] PAPI events multiplexed, "
+	    "counts are scaled estimates\n");
+  memset (totals, 0, sizeof(totals));
+  for (tid = 0; tid < polybench_papi_nb_threads; ++tid)
+    {
+      printf ("[PolyBench] thread %d:", tid);
+      for (evid = 0; evid < polybench_papi_nb_events; ++evid)
+	{
+	  totals[evid] += polybench_papi_thread_values[tid][evid];
+	  if (verbose)
+	    printf (" %s=", _polybench_papi_eventlist[evid]);
+	  else
+	    printf (" ");
+	  printf ("%llu", polybench_papi_thread_values[tid][evid]);
+	}
+      polybench_print_metrics (_polybench_papi_eventlist, polybench_papi_nb_events,
+			       polybench_papi_thread_values[tid]);
+      printf ("\n");
+    }
+  printf ("[PolyBench] all threads:");
+  polybench_print_metrics (_polybench_papi_eventlist, polybench_papi_nb_events,
+			   totals);
+  printf ("\n");
+  for (evid = 0; evid < polybench_papi_nb_events; ++evid)
+    {
+      polybench_papi_values[evid] = totals[evid];
+      if (verbose)
+	printf ("%s=", _polybench_papi_eventlist[evid]);
+      printf ("%llu ", totals[evid]);
+      if (verbose)
+	printf ("\n");
+    }
+  printf ("\n");
+}
+
+# else
+/* Serialized mode: the kernel is run once per event, which is counted
+   on thread polybench_papi_counters_threadid only. */
+
+void polybench_papi_init()
+{
+# ifdef _OPENMP
+#pragma omp parallel
+  {
+#pragma omp master
+    {
+      if (omp_get_max_threads () < polybench_papi_counters_threadid)
+	polybench_papi_counters_threadid = omp_get_max_threads () - 1;
+    }
+#pragma omp barrier
+
+    if (omp_get_thread_num () == polybench_papi_counters_threadid)
+      {
+# endif
+	int retval;
+	polybench_papi_eventset = PAPI_NULL;
+	if ((retval = PAPI_library_init (PAPI_VER_CURRENT)) != PAPI_VER_CURRENT)
+	  test_fail (__FILE__, __LINE__, "PAPI_library_init", retval);
+	if ((retval = PAPI_create_eventset (&polybench_papi_eventset))
+	    != PAPI_OK)
+	  test_fail (__FILE__, __LINE__, "PAPI_create_eventset", retval);
+	int k;
+	for (k = 0; _polybench_papi_eventlist[k]; ++k)
+	  {
+	    if ((retval =
+		 PAPI_event_name_to_code (_polybench_papi_eventlist[k],
+					  &(polybench_papi_eventlist[k])))
+		!= PAPI_OK)
+	      test_fail (__FILE__, __LINE__, "PAPI_event_name_to_code", retval);
+	  }
+	polybench_papi_eventlist[k] = 0;
+
+
+# ifdef _OPENMP
+      }
+  }
+#pragma omp barrier
+# endif
+}
+
+
+void polybench_papi_close()
+{
+# ifdef _OPENMP
+#pragma omp parallel
+  {
+    if (omp_get_thread_num () == polybench_papi_counters_threadid)
+      {
+# endif
+	int retval;
+	if ((retval = PAPI_destroy_eventset (&polybench_papi_eventset))
+	    != PAPI_OK)
+	  test_fail (__FILE__, __LINE__, "PAPI_destroy_eventset", retval);
+	if (PAPI_is_initialized ())
+	  PAPI_shutdown ();
+# ifdef _OPENMP
+      }
+  }
+#pragma omp barrier
 # endif
 }
 
@@ -315,9 +1139,294 @@ void polybench_papi_print()
 # endif
 }
 
+
+# endif
 #endif
 /* ! POLYBENCH_PAPI */
 
+#ifdef POLYBENCH_PERF
+/* Linux perf_event_open backend. The counters listed in the
+   POLYBENCH_PERF_EVENTS environment variable (comma separated perf
+   names) are opened on every OpenMP thread, and count that thread
+   only. By default, hardware events are used, or software events when
+   the host does not expose the PMU. */
+# include <sys/ioctl.h>
+# include <linux/perf_event.h>
+# define POLYBENCH_MAX_NB_PERF_COUNTERS 32
+# define POLYBENCH_PERF_HW_EVENTS \
+  "cycles,instructions,cache-references,cache-misses,branch-misses"
+# define POLYBENCH_PERF_SW_EVENTS \
+  "task-clock,page-faults,context-switches,cpu-migrations"
+# define POLYBENCH_PERF_CACHE(cache, op, result)	\
+  ((cache) | ((op) << 8) | ((result) << 16))
+
+static struct {
+  const char* name;
+  unsigned int type;
+  unsigned long long config;
+} polybench_perf_events[] = {
+  { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+  { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+  { "cache-references", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES },
+  { "cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+  { "branches", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS },
+  { "branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+  { "ref-cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_REF_CPU_CYCLES },
+  { "stalled-cycles-frontend", PERF_TYPE_HARDWARE,
+    PERF_COUNT_HW_STALLED_CYCLES_FRONTEND },
+  { "stalled-cycles-backend", PERF_TYPE_HARDWARE,
+    PERF_COUNT_HW_STALLED_CYCLES_BACKEND },
+  { "L1-dcache-loads", PERF_TYPE_HW_CACHE,
+    POLYBENCH_PERF_CACHE (PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+			  PERF_COUNT_HW_CACHE_RESULT_ACCESS) },
+  { "L1-dcache-load-misses", PERF_TYPE_HW_CACHE,
+    POLYBENCH_PERF_CACHE (PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+			  PERF_COUNT_HW_CACHE_RESULT_MISS) },
+  { "LLC-loads", PERF_TYPE_HW_CACHE,
+    POLYBENCH_PERF_CACHE (PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ,
+			  PERF_COUNT_HW_CACHE_RESULT_ACCESS) },
+  { "LLC-load-misses", PERF_TYPE_HW_CACHE,
+    POLYBENCH_PERF_CACHE (PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ,
+			  PERF_COUNT_HW_CACHE_RESULT_MISS) },
+  { "task-clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+  { "page-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+  { "minor-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MIN },
+  { "major-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MAJ },
+  { "context-switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+  { "cpu-migrations", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS },
+  { NULL, 0, 0 }
+};
+
+char* polybench_perf_eventlist[POLYBENCH_MAX_NB_PERF_COUNTERS];
+int polybench_perf_eventcodes[POLYBENCH_MAX_NB_PERF_COUNTERS];
+int polybench_perf_nb_events = 0;
+int polybench_perf_nb_threads = 1;
+int polybench_perf_multiplexed = 0;
+int polybench_perf_fds[POLYBENCH_MAX_NB_THREADS][POLYBENCH_MAX_NB_PERF_COUNTERS];
+long long polybench_perf_values[POLYBENCH_MAX_NB_THREADS][POLYBENCH_MAX_NB_PERF_COUNTERS];
+long long polybench_perf_totals[POLYBENCH_MAX_NB_PERF_COUNTERS];
+
+
+/* Open one counter on the calling thread. Kernel events are excluded
+   when the perf_event_paranoid level does not allow them. */
+static
+int polybench_perf_open(int code)
+{
+  struct perf_event_attr attr;
+  int fd;
+
+  memset (&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = polybench_perf_events[code].type;
+  attr.config = polybench_perf_events[code].config;
+  attr.disabled = 1;
+  attr.read_format =
+    PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  fd = syscall (__NR_perf_event_open, &attr, 0, -1, -1, 0);
+  if (fd < 0 && (errno == EACCES || errno == EPERM))
+    {
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      fd = syscall (__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+  return fd;
+}
+
+
+static
+void polybench_perf_parse_events(const char* list)
+{
+  char* names = strdup (list);
+  char* name;
+  int code;
+
+  polybench_perf_nb_events = 0;
+  for (name = strtok (names, ", "); name; name = strtok (NULL, ", "))
+    {
+      for (code = 0; polybench_perf_events[code].name; ++code)
+	if (! strcmp (polybench_perf_events[code].name, name))
+	  break;
+      if (! polybench_perf_events[code].name)
+	{
+	  fprintf (stderr, "[PolyBench] unknown perf event: %s\n", name);
+	  exit (1);
+	}
+      if (polybench_perf_nb_events == POLYBENCH_MAX_NB_PERF_COUNTERS)
+	{
+	  fprintf (stderr, "[PolyBench] too many perf events\n");
+	  exit (1);
+	}
+      polybench_perf_eventlist[polybench_perf_nb_events] =
+	(char*) polybench_perf_events[code].name;
+      polybench_perf_eventcodes[polybench_perf_nb_events++] = code;
+    }
+  free (names);
+}
+
+
+void polybench_perf_init()
+{
+  const char* list = getenv ("POLYBENCH_PERF_EVENTS");
+  int evid, fd;
+
+  if (list && *list)
+    {
+      polybench_perf_parse_events (list);
+      return;
+    }
+  /* Probe the PMU with the default hardware events. */
+  polybench_perf_parse_events (POLYBENCH_PERF_HW_EVENTS);
+  for (evid = 0; evid < polybench_perf_nb_events; ++evid)
+    {
+      fd = polybench_perf_open (polybench_perf_eventcodes[evid]);
+      if (fd >= 0)
+	{
+	  close (fd);
+	  return;
+	}
+    }
+  printf ("[PolyBench][WARNING] hardware counters unavailable (%s), "
+	  "using software events\n", strerror (errno));
+  polybench_perf_parse_events (POLYBENCH_PERF_SW_EVENTS);
+}
+
+
+void polybench_perf_start()
+{
+  polybench_perf_nb_threads = 1;
+  polybench_perf_multiplexed = 0;
+# ifdef _OPENMP
+#pragma omp parallel
+  {
+#pragma omp master
+    polybench_perf_nb_threads = omp_get_num_threads ();
+    int tid = omp_get_thread_num ();
+# else
+    int tid = 0;
+# endif
+    int evid;
+
+    if (tid >= POLYBENCH_MAX_NB_THREADS)
+      {
+	fprintf (stderr, "[PolyBench] more than %d threads\n",
+		 POLYBENCH_MAX_NB_THREADS);
+	exit (1);
+      }
+    for (evid = 0; evid < polybench_perf_nb_events; ++evid)
+      polybench_perf_fds[tid][evid] =
+	polybench_perf_open (polybench_perf_eventcodes[evid]);
+    for (evid = 0; evid < polybench_perf_nb_events; ++evid)
+      if (polybench_perf_fds[tid][evid] >= 0)
+	{
+	  ioctl (polybench_perf_fds[tid][evid], PERF_EVENT_IOC_RESET, 0);
+	  ioctl (polybench_perf_fds[tid][evid], PERF_EVENT_IOC_ENABLE, 0);
+	}
+# ifdef _OPENMP
+  }
+# endif
+}
+
+
+void polybench_perf_stop()
+{
+# ifdef _OPENMP
+#pragma omp parallel
+  {
+    int tid = omp_get_thread_num ();
+# else
+    int tid = 0;
+# endif
+    int evid;
+
+    for (evid = 0; evid < polybench_perf_nb_events; ++evid)
+      if (polybench_perf_fds[tid][evid] >= 0)
+	ioctl (polybench_perf_fds[tid][evid], PERF_EVENT_IOC_DISABLE, 0);
+    for (evid = 0; evid < polybench_perf_nb_events; ++evid)
+      {
+	/* value, time enabled, time running. */
+	unsigned long long data[3];
+	int fd = polybench_perf_fds[tid][evid];
+
+	polybench_perf_values[tid][evid] = -1;
+	if (fd < 0)
+	  continue;
+	if (read (fd, data, sizeof(data)) == sizeof(data) && data[2] > 0)
+	  {
+	    /* Scale the count when the counter was multiplexed. */
+	    if (data[2] < data[1])
+	      {
+		polybench_perf_multiplexed = 1;
+		data[0] = (unsigned long long)
+		  ((double) data[0] * data[1] / data[2]);
+	      }
+	    polybench_perf_values[tid][evid] = data[0];
+	  }
+	close (fd);
+      }
+# ifdef _OPENMP
+  }
+# endif
+}
+
+
+void polybench_perf_print()
+{
+  int verbose = 0;
+  int tid, evid;
+  long long totals[POLYBENCH_MAX_NB_PERF_COUNTERS];
+
+#ifdef POLYBENCH_PAPI_VERBOSE
+  verbose = 1;
+#endif
+  if (polybench_perf_multiplexed)
+    printf ("[PolyBench][WARNING] perf events multiplexed, "
+	    "counts are scaled estimates\n");
+  for (evid = 0; evid < polybench_perf_nb_events; ++evid)
+    totals[evid] = -1;
+  for (tid = 0; tid < polybench_perf_nb_threads; ++tid)
+    {
+      printf ("[PolyBench] thread %d:", tid);
+      for (evid = 0; evid < polybench_perf_nb_events; ++evid)
+	{
+	  long long val = polybench_perf_values[tid][evid];
+	  if (val >= 0)
+	    totals[evid] = (totals[evid] < 0 ? 0 : totals[evid]) + val;
+	  if (verbose)
+	    printf (" %s=", polybench_perf_eventlist[evid]);
+	  else
+	    printf (" ");
+	  if (val >= 0)
+	    printf ("%lld", val);
+	  else
+	    printf ("-");
+	}
+      polybench_print_metrics (polybench_perf_eventlist,
+			       polybench_perf_nb_events,
+			       polybench_perf_values[tid]);
+      printf ("\n");
+    }
+  printf ("[PolyBench] all threads:");
+  polybench_print_metrics (polybench_perf_eventlist, polybench_perf_nb_events,
+			   totals);
+  printf ("\n");
+  for (evid = 0; evid < polybench_perf_nb_events; ++evid)
+    {
+      polybench_perf_totals[evid] = totals[evid];
+      if (verbose)
+	printf ("%s=", polybench_perf_eventlist[evid]);
+      if (totals[evid] >= 0)
+	printf ("%lld ", totals[evid]);
+      else
+	printf ("- ");
+      if (verbose)
+	printf ("\n");
+    }
+  printf ("\n");
+}
+
+#endif
+/* ! POLYBENCH_PERF */
+
 void polybench_prepare_instruments()
 {
 #ifndef POLYBENCH_NO_FLUSH_CACHE
@@ -329,74 +1438,2168 @@ void polybench_prepare_instruments()
 }
 
 
-void polybench_timer_start()
-{
-  polybench_prepare_instruments ();
-#ifndef POLYBENCH_CYCLE_ACCURATE_TIMER
-  polybench_t_start = rtclock ();
+#ifdef POLYBENCH_ROOFLINE
+/* Roofline of the host: sustained memory bandwidth (STREAM triad) and
+   peak flop rate (independent multiply-add chains), both with the
+   current number of OpenMP threads and the compiler flags of the
+   benchmark. */
+double polybench_roofline_bw = 0;
+double polybench_roofline_peak = 0;
+
+/* Widest vector of the instruction set the benchmark is compiled for. */
+#if defined(__AVX512F__)
+# define POLYBENCH_VECTOR_BYTES 64
+#elif defined(__AVX__)
+# define POLYBENCH_VECTOR_BYTES 32
 #else
-  polybench_c_start = rdtsc ();
+# define POLYBENCH_VECTOR_BYTES 16
 #endif
-}
+typedef double polybench_vdf __attribute__ ((vector_size (POLYBENCH_VECTOR_BYTES)));
 
 
-void polybench_timer_stop()
+static
+double polybench_measure_bandwidth()
 {
-#ifndef POLYBENCH_CYCLE_ACCURATE_TIMER
-  polybench_t_end = rtclock ();
-#else
-  polybench_c_end = rdtsc ();
+  size_t private_size, llc_size, n, i;
+  double *a, *b, *c, best = 0;
+  int rep;
+
+  /* Each array is four times the LLCs, and at least 32 MB. */
+  polybench_cache_topology (&private_size, &llc_size);
+  n = 4 * llc_size / sizeof(double);
+  if (n < 4 * 1024 * 1024)
+    n = 4 * 1024 * 1024;
+  if (posix_memalign ((void**) &a, 64, n * sizeof(double))
+      || posix_memalign ((void**) &b, 64, n * sizeof(double))
+      || posix_memalign ((void**) &c, 64, n * sizeof(double)))
+    {
+      fprintf (stderr, "[PolyBench] cannot allocate the STREAM arrays\n");
+      exit (1);
+    }
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
 #endif
-#ifdef POLYBENCH_LINUX_FIFO_SCHEDULER
-  polybench_linux_standard_scheduler ();
+  for (i = 0; i < n; i++)
+    {
+      a[i] = 0.0;
+      b[i] = 1.0;
+      c[i] = 2.0;
+    }
+  for (rep = 0; rep < 5; rep++)
+    {
+      double t = rtclock ();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
 #endif
+      for (i = 0; i < n; i++)
+	a[i] = b[i] + 3.0 * c[i];
+      t = rtclock () - t;
+      if (t > 0 && 3.0 * n * sizeof(double) / t > best)
+	best = 3.0 * n * sizeof(double) / t;
+    }
+  polybench_flush_sink = a[n / 2];
+  free (a);
+  free (b);
+  free (c);
+  return best / 1e9;
 }
 
 
-void polybench_timer_print()
+static
+double polybench_measure_peak()
 {
-#ifdef POLYBENCH_GFLOPS
-      if  (__polybench_program_total_flops == 0)
-	{
-	  printf ("[PolyBench][WARNING] Program flops not defined, use polybench_set_program_flops(value)\n");
-	  printf ("%0.6lf\n", polybench_t_end - polybench_t_start);
-	}
-      else
-	printf ("%0.2lf\n",
-		(__polybench_program_total_flops /
-		 (double)(polybench_t_end - polybench_t_start)) / 1000000000);
-#else
-# ifndef POLYBENCH_CYCLE_ACCURATE_TIMER
-      printf ("%0.6f\n", polybench_t_end - polybench_t_start);
-# else
-      printf ("%Ld\n", polybench_c_end - polybench_c_start);
-# endif
+  const long iters = 20000000;
+  int nb_threads = 1;
+  double t, sink = 0;
+
+  t = rtclock ();
+#ifdef _OPENMP
+#pragma omp parallel reduction(+:sink)
+#endif
+  {
+    /* Enough independent chains to hide the latency of the units. */
+    volatile double va = 0.999999, vb = 1e-9;
+    polybench_vdf x, y, c0, c1, c2, c3, c4, c5, c6, c7;
+    long i;
+    x = va - (polybench_vdf) {};
+    y = vb - (polybench_vdf) {};
+    c0 = x, c1 = y, c2 = x + y, c3 = x - y;
+    c4 = x * y, c5 = y + y, c6 = x + x, c7 = x * x;
+#ifdef _OPENMP
+#pragma omp master
+    nb_threads = omp_get_num_threads ();
 #endif
+    for (i = 0; i < iters; i++)
+      {
+	c0 = c0 * x + y;
+	c1 = c1 * x + y;
+	c2 = c2 * x + y;
+	c3 = c3 * x + y;
+	c4 = c4 * x + y;
+	c5 = c5 * x + y;
+	c6 = c6 * x + y;
+	c7 = c7 * x + y;
+      }
+    c0 = c0 + c1 + c2 + c3 + c4 + c5 + c6 + c7;
+    for (i = 0; i < POLYBENCH_VECTOR_BYTES / 8; i++)
+      sink += c0[i];
+  }
+  t = rtclock () - t;
+  polybench_flush_sink = sink;
+  return 8.0 * (POLYBENCH_VECTOR_BYTES / 8) * 2 * iters * nb_threads
+    / t / 1e9;
 }
 
 
-
+/* Look the roofline of this host up in the cache file, or measure it
+   and append it to the file. */
 static
-void *
-xmalloc (size_t num)
+void polybench_roofline_init()
 {
-  void* new = NULL;
-  int ret = posix_memalign (&new, 32, num);
-  if (! new || ret)
+  char path[1024], host[256], line[512], h[256];
+  const char* file = getenv ("POLYBENCH_ROOFLINE_CACHE");
+  int nb_threads = 1, th;
+  double bw, peak;
+  FILE* f;
+
+  if (polybench_roofline_peak > 0)
+    return;
+#ifdef _OPENMP
+  nb_threads = omp_get_max_threads ();
+#endif
+  if (file == NULL || *file == '\0')
     {
-      fprintf (stderr, "[PolyBench] posix_memalign: cannot allocate memory");
-      exit (1);
+      snprintf (path, sizeof(path), "%s/.polybench_roofline",
+		getenv ("HOME") ? getenv ("HOME") : ".");
+      file = path;
+    }
+  if (gethostname (host, sizeof(host)))
+    strcpy (host, "localhost");
+  host[sizeof(host) - 1] = '\0';
+  if ((f = fopen (file, "r")))
+    {
+      while (fgets (line, sizeof(line), f))
+	if (sscanf (line, "%255s %d %lf %lf", h, &th, &bw, &peak) == 4
+	    && ! strcmp (h, host) && th == nb_threads)
+	  {
+	    polybench_roofline_bw = bw;
+	    polybench_roofline_peak = peak;
+	  }
+      fclose (f);
+    }
+  if (polybench_roofline_peak > 0)
+    return;
+  polybench_roofline_bw = polybench_measure_bandwidth ();
+  polybench_roofline_peak = polybench_measure_peak ();
+  if ((f = fopen (file, "a")))
+    {
+      fprintf (f, "%s %d %0.3f %0.3f\n", host, nb_threads,
+	       polybench_roofline_bw, polybench_roofline_peak);
+      fclose (f);
     }
-  return new;
 }
 
 
-void* polybench_alloc_data(unsigned long long int n, int elt_size)
+static
+void polybench_roofline_print(double elapsed)
 {
-  /// FIXME: detect overflow!
-  size_t val = n;
-  val *= elt_size;
-  void* ret = xmalloc (val);
+  double gflops, ai, attainable, ridge;
+
+  if (polybench_program_total_flops == 0 || polybench_program_total_bytes == 0
+      || elapsed <= 0)
+    {
+      printf ("[PolyBench][WARNING] Program flops or bytes not defined, use polybench_set_program_flops/bytes(value)\n");
+      return;
+    }
+  gflops = polybench_program_total_flops / elapsed / 1e9;
+  ai = polybench_program_total_flops / polybench_program_total_bytes;
+  ridge = polybench_roofline_peak / polybench_roofline_bw;
+  attainable = ai < ridge ? ai * polybench_roofline_bw : polybench_roofline_peak;
+  printf ("[PolyBench][roofline] AI=%0.3f flop/B GFLOP/s=%0.2f "
+	  "bandwidth=%0.2f GB/s peak=%0.2f GFLOP/s ridge=%0.3f flop/B "
+	  "bound=%s attainable=%0.2f GFLOP/s efficiency=%0.1f%%\n",
+	  ai, gflops, polybench_roofline_bw, polybench_roofline_peak, ridge,
+	  ai < ridge ? "memory" : "compute", attainable,
+	  100.0 * gflops / attainable);
+}
+#endif
+
+
+/* POP efficiencies, with POLYBENCH_POP=1. The useful time of an OpenMP
+   thread is its CPU time during the timed runs, which excludes the time
+   it waits at the barriers as long as the waiting threads sleep
+   (OMP_WAIT_POLICY=passive). Over the timed runs, with P threads of
+   useful times u and a run time T:
+   load balance LB = avg(u) / max(u),
+   serialization efficiency SerE = max(u) / T,
+   parallel efficiency PE = LB * SerE = avg(u) / T. */
+int polybench_pop = 0;
+int polybench_pop_nb_threads = 1;
+double polybench_pop_elapsed = 0;
+double polybench_pop_t0 = 0;
+double polybench_pop_cpu0[POLYBENCH_MAX_NB_THREADS];
+double polybench_pop_useful[POLYBENCH_MAX_NB_THREADS];
 
-  return ret;
+
+static
+double polybench_pop_clock(clockid_t clock)
+{
+  struct timespec ts;
+  clock_gettime (clock, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/* CPU time of each thread of the team. */
+static
+void polybench_pop_sample(double* cpu)
+{
+  int nb_threads = 1;
+#ifdef _OPENMP
+#pragma omp parallel
+  {
+    int tid = omp_get_thread_num ();
+#pragma omp master
+    nb_threads = omp_get_num_threads ();
+    if (tid < POLYBENCH_MAX_NB_THREADS)
+      cpu[tid] = polybench_pop_clock (CLOCK_THREAD_CPUTIME_ID);
+  }
+#else
+  cpu[0] = polybench_pop_clock (CLOCK_THREAD_CPUTIME_ID);
+#endif
+  polybench_pop_nb_threads = nb_threads < POLYBENCH_MAX_NB_THREADS
+    ? nb_threads : POLYBENCH_MAX_NB_THREADS;
+}
+
+
+static
+void polybench_pop_init()
+{
+  const char* wait = getenv ("OMP_WAIT_POLICY");
+
+  polybench_pop = polybench_getenv_int ("POLYBENCH_POP", 0);
+  polybench_pop_elapsed = 0;
+  memset (polybench_pop_useful, 0, sizeof(polybench_pop_useful));
+  if (polybench_pop && (wait == NULL || strcasecmp (wait, "passive")))
+    printf ("[PolyBench][WARNING] OMP_WAIT_POLICY is not passive, the "
+	    "useful times include the waiting threads\n");
+}
+
+
+static
+void polybench_pop_start()
+{
+  /* The run time encloses the CPU times. */
+  polybench_pop_t0 = polybench_pop_clock (CLOCK_MONOTONIC);
+  polybench_pop_sample (polybench_pop_cpu0);
+}
+
+
+static
+void polybench_pop_stop()
+{
+  double t1, cpu1[POLYBENCH_MAX_NB_THREADS];
+  int tid;
+
+  polybench_pop_sample (cpu1);
+  t1 = polybench_pop_clock (CLOCK_MONOTONIC);
+  polybench_pop_elapsed += t1 - polybench_pop_t0;
+  for (tid = 0; tid < polybench_pop_nb_threads; tid++)
+    polybench_pop_useful[tid] += cpu1[tid] - polybench_pop_cpu0[tid];
+}
+
+
+static
+void polybench_pop_print()
+{
+  double sum = 0, max = 0, avg;
+  int tid, n = polybench_pop_nb_threads;
+
+  for (tid = 0; tid < n; tid++)
+    {
+      sum += polybench_pop_useful[tid];
+      if (polybench_pop_useful[tid] > max)
+	max = polybench_pop_useful[tid];
+    }
+  avg = sum / n;
+  if (max <= 0 || polybench_pop_elapsed <= 0)
+    return;
+  printf ("[PolyBench][pop] threads=%d runtime=%0.6f useful_sum=%0.6f "
+	  "useful_avg=%0.6f useful_max=%0.6f LB=%0.2f%% SerE=%0.2f%% "
+	  "PE=%0.2f%%\n", n, polybench_pop_elapsed, sum, avg, max,
+	  100.0 * avg / max, 100.0 * max / polybench_pop_elapsed,
+	  100.0 * avg / polybench_pop_elapsed);
+}
+
+
+/* OS noise probe (fixed work quantum), with POLYBENCH_NOISE=1. Before
+   the first run and after the last one, a thread pinned to each CPU of
+   the process runs POLYBENCH_NOISE_SAMPLES (default: 10000) quanta of
+   the same work, of about POLYBENCH_NOISE_QUANTUM_US (default: 10)
+   microseconds each. The noise of a CPU is the time its quanta lost
+   over the fastest one, as a percentage of the probe time, and its
+   quanta are binned by their excess over the fastest one. When a CPU
+   exceeds POLYBENCH_NOISE_THRESHOLD percent (default: 1), the host is
+   flagged as noisy, and the timed runs are started over, up to
+   POLYBENCH_NOISE_RETRIES times (default: 0). */
+#define POLYBENCH_NOISE_NB_BINS 6
+
+struct polybench_noise_cpu
+{
+  int cpu;
+  int nb_samples;
+  unsigned long long* samples;
+  double noise;
+  unsigned long long max;
+  long long bins[POLYBENCH_NOISE_NB_BINS];
+  double sink;
+};
+
+int polybench_noise = 0;
+int polybench_noise_retries = 0;
+int polybench_noise_retry = 0;
+double polybench_noise_threshold = 1.0;
+long long polybench_noise_iters = 0;
+double polybench_noise_before = -1;
+double polybench_noise_after = -1;
+
+
+static
+double polybench_noise_work(long long n)
+{
+  double x = 1.0;
+  long long i;
+
+  for (i = 0; i < n; i++)
+    x = x * 1.0000001 + 1e-9;
+  return x;
+}
+
+
+/* Number of iterations of polybench_noise_work in a quantum. */
+static
+void polybench_noise_calibrate()
+{
+  unsigned long long t0, t1, quantum;
+  long long n = 1024;
+  double sink = 0;
+
+  quantum = 1000ULL * polybench_getenv_int ("POLYBENCH_NOISE_QUANTUM_US", 10);
+  do
+    {
+      n *= 2;
+      t0 = polybench_clock_ns ();
+      sink += polybench_noise_work (n);
+      t1 = polybench_clock_ns ();
+    }
+  while (t1 - t0 < 1000000 && n < (1LL << 40));
+  polybench_noise_iters = (long long) ((double) n * quantum / (t1 - t0));
+  if (polybench_noise_iters < 1 || sink == 0)
+    polybench_noise_iters = 1;
+}
+
+
+static
+void* polybench_noise_thread(void* arg)
+{
+  struct polybench_noise_cpu* c = (struct polybench_noise_cpu*) arg;
+  unsigned long long t0, t1, min = ~0ULL, lost = 0, total = 0;
+  const double edges[POLYBENCH_NOISE_NB_BINS - 1] =
+    { 0.01, 0.1, 1, 10, 100 };
+  int i, b;
+
+  for (i = 0; i < c->nb_samples; i++)
+    {
+      t0 = polybench_clock_ns ();
+      c->sink += polybench_noise_work (polybench_noise_iters);
+      t1 = polybench_clock_ns ();
+      c->samples[i] = t1 - t0;
+    }
+  for (i = 0; i < c->nb_samples; i++)
+    if (c->samples[i] < min)
+      min = c->samples[i];
+  if (min == 0)
+    min = 1;
+  for (i = 0; i < c->nb_samples; i++)
+    {
+      double excess = (double) (c->samples[i] - min) / min;
+      for (b = 0; b < POLYBENCH_NOISE_NB_BINS - 1 && excess >= edges[b]; b++)
+	;
+      c->bins[b]++;
+      lost += c->samples[i] - min;
+      total += c->samples[i];
+      if (c->samples[i] - min > c->max)
+	c->max = c->samples[i] - min;
+    }
+  c->noise = total ? 100.0 * lost / total : 0;
+  return NULL;
+}
+
+
+/* Run the probe on every CPU at once, print the histograms and return
+   the noise of the noisiest CPU. */
+static
+double polybench_noise_probe(const char* when)
+{
+  const char* labels[POLYBENCH_NOISE_NB_BINS] =
+    { "<1%", "<10%", "<2x", "<11x", "<101x", ">=101x" };
+  struct polybench_noise_cpu* cpus;
+  pthread_t* threads;
+  pthread_attr_t attr;
+  cpu_set_t set, one;
+  int nb_cpus = 0, nb_samples, i, b;
+  double worst = 0;
+
+  nb_samples = polybench_getenv_int ("POLYBENCH_NOISE_SAMPLES", 10000);
+  if (nb_samples < 1)
+    nb_samples = 1;
+  if (polybench_noise_iters == 0)
+    polybench_noise_calibrate ();
+  if (sched_getaffinity (0, sizeof(set), &set))
+    {
+      CPU_ZERO (&set);
+      CPU_SET (sched_getcpu () >= 0 ? sched_getcpu () : 0, &set);
+    }
+  cpus = (struct polybench_noise_cpu*)
+    calloc (CPU_COUNT (&set), sizeof(struct polybench_noise_cpu));
+  threads = (pthread_t*) calloc (CPU_COUNT (&set), sizeof(pthread_t));
+  if (! cpus || ! threads)
+    {
+      fprintf (stderr, "[PolyBench] cannot allocate the noise probe\n");
+      exit (1);
+    }
+  for (i = 0; i < CPU_SETSIZE && nb_cpus < CPU_COUNT (&set); i++)
+    if (CPU_ISSET (i, &set))
+      {
+	struct polybench_noise_cpu* c = &cpus[nb_cpus];
+	c->cpu = i;
+	c->nb_samples = nb_samples;
+	c->samples = (unsigned long long*)
+	  malloc (nb_samples * sizeof(unsigned long long));
+	if (! c->samples)
+	  {
+	    fprintf (stderr, "[PolyBench] cannot allocate the noise probe\n");
+	    exit (1);
+	  }
+	pthread_attr_init (&attr);
+	CPU_ZERO (&one);
+	CPU_SET (i, &one);
+	pthread_attr_setaffinity_np (&attr, sizeof(one), &one);
+	if (pthread_create (&threads[nb_cpus], &attr, polybench_noise_thread, c))
+	  {
+	    fprintf (stderr, "[PolyBench] cannot start the noise probe on "
+		     "CPU %d\n", i);
+	    exit (1);
+	  }
+	pthread_attr_destroy (&attr);
+	nb_cpus++;
+      }
+  for (i = 0; i < nb_cpus; i++)
+    {
+      struct polybench_noise_cpu* c = &cpus[i];
+      pthread_join (threads[i], NULL);
+      printf ("[PolyBench][noise] %s cpu=%d noise=%0.3f%% max=%0.1f us",
+	      when, c->cpu, c->noise, c->max * 1e-3);
+      for (b = 0; b < POLYBENCH_NOISE_NB_BINS; b++)
+	printf (" %s:%lld", labels[b], c->bins[b]);
+      printf ("\n");
+      if (c->noise > worst)
+	worst = c->noise;
+      free (c->samples);
+    }
+  free (threads);
+  free (cpus);
+  if (worst > polybench_noise_threshold)
+    printf ("[PolyBench][WARNING] OS noise %0.3f%% %s the runs exceeds "
+	    "%0.3f%%, the host is noisy\n", worst, when,
+	    polybench_noise_threshold);
+  return worst;
+}
+
+
+static
+void polybench_noise_init()
+{
+  polybench_noise = polybench_getenv_int ("POLYBENCH_NOISE", 0);
+  polybench_noise_retries =
+    polybench_getenv_int ("POLYBENCH_NOISE_RETRIES", 0);
+  polybench_noise_threshold =
+    polybench_getenv_double ("POLYBENCH_NOISE_THRESHOLD", 1.0);
+  polybench_noise_retry = 0;
+  polybench_noise_before = polybench_noise_after = -1;
+  if (polybench_noise)
+    polybench_noise_before = polybench_noise_probe ("before");
+}
+
+
+/* After the last run: probe again, and tell if the timed runs must be
+   started over. */
+static
+int polybench_noise_check()
+{
+  polybench_noise_after = polybench_noise_probe ("after");
+  if ((polybench_noise_before <= polybench_noise_threshold
+       && polybench_noise_after <= polybench_noise_threshold)
+      || polybench_noise_retry >= polybench_noise_retries)
+    return 0;
+  polybench_noise_retry++;
+  printf ("[PolyBench][noise] retry %d of %d\n", polybench_noise_retry,
+	  polybench_noise_retries);
+  /* The probe after the discarded runs is the one before the new ones. */
+  polybench_noise_before = polybench_noise_after;
+  return 1;
+}
+
+#if defined(POLYBENCH_RUNTIME_SCHEDULE) && defined(_OPENMP)
+/* The schedule(runtime) of the worksharing loops, as parsed from
+   OMP_SCHEDULE by the OpenMP runtime. */
+static
+const char* polybench_schedule_name()
+{
+  static char name[64];
+  const char* kinds[5] = { "?", "static", "dynamic", "guided", "auto" };
+  omp_sched_t kind;
+  int chunk, k;
+
+  omp_get_schedule (&kind, &chunk);
+  /* Drop the monotonic modifier bit. */
+  k = (int) ((unsigned) kind & 0x7fffffffu);
+  if (k < 1 || k > 4)
+    k = 0;
+  if (chunk > 0 && k != 4)
+    snprintf (name, sizeof(name), "%s%s,%d",
+	      (unsigned) kind & 0x80000000u ? "monotonic:" : "",
+	      kinds[k], chunk);
+  else
+    snprintf (name, sizeof(name), "%s%s",
+	      (unsigned) kind & 0x80000000u ? "monotonic:" : "", kinds[k]);
+  return name;
+}
+#endif
+
+
+void polybench_repeat_init()
+{
+  polybench_nb_runs = polybench_getenv_int ("POLYBENCH_REPETITIONS", 1);
+  polybench_nb_warmup = polybench_getenv_int ("POLYBENCH_WARMUP", 0);
+  polybench_cv_threshold =
+    polybench_getenv_double ("POLYBENCH_CV_THRESHOLD", 5.0);
+  if (polybench_nb_runs < 1)
+    polybench_nb_runs = 1;
+  if (polybench_nb_warmup < 0)
+    polybench_nb_warmup = 0;
+  polybench_run = 0;
+#ifdef POLYBENCH_ROOFLINE
+  polybench_roofline_init ();
+#endif
+  polybench_pop_init ();
+  polybench_noise_init ();
+  polybench_tsc_init ();
+  polybench_stamps_nb_runs = 0;
+  polybench_stamps_skew_sum = 0;
+  polybench_stamps_skew_max = 0;
+#if defined(POLYBENCH_RUNTIME_SCHEDULE) && defined(_OPENMP)
+  printf ("[PolyBench] schedule=%s\n", polybench_schedule_name ());
+#endif
+  free (polybench_t_samples);
+  polybench_t_samples = (double*) calloc (polybench_nb_runs, sizeof(double));
+  if (! polybench_t_samples)
+    {
+      fprintf (stderr, "[PolyBench] cannot allocate the timing samples\n");
+      exit (1);
+    }
+}
+
+
+int polybench_repeat_next()
+{
+  if (polybench_run < polybench_nb_warmup + polybench_nb_runs)
+    {
+      polybench_run++;
+      return 1;
+    }
+  if (polybench_noise && polybench_noise_check ())
+    {
+      /* Start the timed runs over, without the warm-up runs. */
+      polybench_run = polybench_nb_warmup + 1;
+      polybench_pop_elapsed = 0;
+      memset (polybench_pop_useful, 0, sizeof(polybench_pop_useful));
+      polybench_stamps_nb_runs = 0;
+      polybench_stamps_skew_sum = 0;
+      polybench_stamps_skew_max = 0;
+      return 1;
+    }
+  return 0;
+}
+
+
+void polybench_timer_start()
+{
+  polybench_prepare_instruments ();
+  if (polybench_pop && polybench_run > polybench_nb_warmup)
+    polybench_pop_start ();
+  polybench_stamps_nb_threads = 0;
+#ifndef POLYBENCH_CYCLE_ACCURATE_TIMER
+  polybench_t_start = rtclock ();
+#else
+  polybench_c_start = polybench_stamp_begin ();
+#endif
+}
+
+
+void polybench_timer_stop()
+{
+#ifndef POLYBENCH_CYCLE_ACCURATE_TIMER
+  polybench_t_end = rtclock ();
+#else
+  polybench_c_end = polybench_stamp_end ();
+#endif
+#ifdef POLYBENCH_LINUX_FIFO_SCHEDULER
+  polybench_linux_standard_scheduler ();
+#endif
+  /* Record the sample, unless this is a warm-up run. */
+  int sample = polybench_run - 1 - polybench_nb_warmup;
+  if (polybench_pop && sample >= 0)
+    polybench_pop_stop ();
+  if (sample >= 0)
+    polybench_stamps_collect ();
+  if (polybench_t_samples && sample >= 0 && sample < polybench_nb_runs)
+#ifndef POLYBENCH_CYCLE_ACCURATE_TIMER
+    polybench_t_samples[sample] = polybench_t_end - polybench_t_start;
+#else
+    polybench_t_samples[sample] = (double)(polybench_c_end - polybench_c_start);
+#endif
+}
+
+
+static
+int polybench_compare_double(const void* a, const void* b)
+{
+  double x = *(const double*) a;
+  double y = *(const double*) b;
+  return (x > y) - (x < y);
+}
+
+
+/* Statistics of the timed runs. The percentile uses the nearest-rank
+   method on the sorted samples. */
+static
+void polybench_timer_stats(double* min, double* median, double* mean,
+			   double* stddev, double* p95)
+{
+  int n = polybench_nb_runs;
+  int i;
+  double* sorted = (double*) malloc (n * sizeof(double));
+  memcpy (sorted, polybench_t_samples, n * sizeof(double));
+  qsort (sorted, n, sizeof(double), polybench_compare_double);
+  *min = sorted[0];
+  *median = n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+  *p95 = sorted[(int) ceil (0.95 * n) - 1];
+  *mean = 0;
+  for (i = 0; i < n; i++)
+    *mean += sorted[i];
+  *mean /= n;
+  *stddev = 0;
+  for (i = 0; i < n; i++)
+    *stddev += (sorted[i] - *mean) * (sorted[i] - *mean);
+  *stddev = n > 1 ? sqrt (*stddev / (n - 1)) : 0;
+  free (sorted);
+}
+
+
+void polybench_timer_print()
+{
+  double elapsed;
+#ifdef POLYBENCH_CYCLE_ACCURATE_TIMER
+  double ticks;
+#endif
+#ifndef POLYBENCH_CYCLE_ACCURATE_TIMER
+  elapsed = polybench_t_end - polybench_t_start;
+#else
+  elapsed = (double)(polybench_c_end - polybench_c_start);
+#endif
+  if (polybench_t_samples && polybench_nb_runs > 1)
+    {
+      double min, median, mean, stddev, p95, cv;
+      polybench_timer_stats (&min, &median, &mean, &stddev, &p95);
+      cv = mean > 0 ? 100.0 * stddev / mean : 0;
+#ifndef POLYBENCH_CYCLE_ACCURATE_TIMER
+      printf ("[PolyBench] runs=%d warmup=%d min=%0.6f median=%0.6f "
+	      "mean=%0.6f stddev=%0.6f p95=%0.6f cv=%0.2f%%\n",
+#else
+      printf ("[PolyBench] runs=%d warmup=%d min=%0.0f median=%0.0f "
+	      "mean=%0.0f stddev=%0.0f p95=%0.0f cv=%0.2f%%\n",
+#endif
+	      polybench_nb_runs, polybench_nb_warmup,
+	      min, median, mean, stddev, p95, cv);
+      if (cv > polybench_cv_threshold)
+	printf ("[PolyBench][WARNING] coefficient of variation %0.2f%% "
+		"exceeds %0.2f%%, timings are not reliable\n",
+		cv, polybench_cv_threshold);
+      elapsed = median;
+    }
+  if (polybench_pop)
+    polybench_pop_print ();
+  polybench_stamps_print ();
+#ifdef POLYBENCH_CYCLE_ACCURATE_TIMER
+  /* The rates are computed from seconds. */
+  ticks = elapsed;
+  elapsed = ticks / polybench_tsc_calibrate () * 1e-9;
+  if (polybench_tsc > 0)
+    printf ("[PolyBench] %0.0f TSC ticks at %0.3f GHz, %0.9f s\n",
+	    ticks, polybench_tsc_ghz, elapsed);
+  else
+    printf ("[PolyBench] ticks are CLOCK_MONOTONIC_RAW nanoseconds\n");
+#endif
+#ifdef POLYBENCH_ROOFLINE
+  polybench_roofline_print (elapsed);
+#endif
+#ifdef POLYBENCH_GFLOPS
+      if  (polybench_program_total_flops == 0)
+	{
+	  printf ("[PolyBench][WARNING] Program flops not defined, use polybench_set_program_flops(value)\n");
+	  printf ("%0.6lf\n", elapsed);
+	}
+      else
+	printf ("%0.2lf\n",
+		(polybench_program_total_flops /
+		 elapsed) / 1000000000);
+#else
+# ifndef POLYBENCH_CYCLE_ACCURATE_TIMER
+      printf ("%0.6f\n", elapsed);
+# else
+      printf ("%llu\n", (unsigned long long) ticks);
+# endif
+#endif
+}
+
+
+/* Run records. With POLYBENCH_RECORD=<file>, each run appends a record
+   to <file>: a CSV line if the name ends in ".csv" (the header line is
+   written first when the file is empty), a JSON object per line
+   otherwise. The compiler flags are given with
+   -DPOLYBENCH_COMPILE_FLAGS="\"...\"" (the Makefiles do it). */
+#ifndef POLYBENCH_COMPILE_FLAGS
+# define POLYBENCH_COMPILE_FLAGS ""
+#endif
+#ifdef __VERSION__
+# define POLYBENCH_COMPILER __VERSION__
+#else
+# define POLYBENCH_COMPILER "unknown"
+#endif
+
+static
+void polybench_record_string(FILE* f, const char* s, int csv)
+{
+  fputc ('"', f);
+  for (; s && *s; s++)
+    if (csv && *s == '"')
+      fputs ("\"\"", f);
+    else if (! csv && (*s == '"' || *s == '\\'))
+      fprintf (f, "\\%c", *s);
+    else if (! csv && (unsigned char) *s < 0x20)
+      fprintf (f, "\\u%04x", *s);
+    else
+      fputc (*s, f);
+  fputc ('"', f);
+}
+
+
+/* Kernel and variant from the program name, e.g. "2mm" and "v1" for
+   2mm_v1. */
+static
+void polybench_record_program(char* kernel, int len, const char** variant)
+{
+  const char* name = "unknown";
+  char* v;
+
+#ifdef __GLIBC__
+  name = program_invocation_short_name;
+#endif
+  snprintf (kernel, len, "%s", name);
+  *variant = "";
+  v = strrchr (kernel, '_');
+  if (v && v[1] == 'v' && v[2] && strspn (v + 2, "0123456789") == strlen (v + 2))
+    {
+      *v = '\0';
+      *variant = name + (v + 1 - kernel);
+    }
+}
+
+
+/* CPU of each OpenMP thread, as placed by OMP_PROC_BIND/OMP_PLACES.
+   Returns the number of threads. */
+static
+int polybench_record_affinity(int* cpus)
+{
+  int nb_threads = 1;
+
+  cpus[0] = sched_getcpu ();
+#ifdef _OPENMP
+#pragma omp parallel
+  {
+    int tid = omp_get_thread_num ();
+#pragma omp master
+    nb_threads = omp_get_num_threads ();
+    if (tid < POLYBENCH_MAX_NB_THREADS)
+      cpus[tid] = sched_getcpu ();
+  }
+  if (nb_threads > POLYBENCH_MAX_NB_THREADS)
+    nb_threads = POLYBENCH_MAX_NB_THREADS;
+#endif
+  return nb_threads;
+}
+
+
+void polybench_record_run(const char* dataset)
+{
+  const char* path = getenv ("POLYBENCH_RECORD");
+  const char* env[3] = { "OMP_PROC_BIND", "OMP_PLACES", "OMP_SCHEDULE" };
+  const char* keys[3] = { "proc_bind", "places", "schedule" };
+  const char* settings[3];
+  const char* instruments = ""
+#ifdef POLYBENCH_TIME
+    " time"
+#endif
+#ifdef POLYBENCH_GFLOPS
+    " gflops"
+#endif
+#ifdef POLYBENCH_CYCLE_ACCURATE_TIMER
+    " cycles"
+#endif
+#ifdef POLYBENCH_PAPI
+    " papi"
+#endif
+#ifdef POLYBENCH_PERF
+    " perf"
+#endif
+#ifdef POLYBENCH_ROOFLINE
+    " roofline"
+#endif
+    ;
+  const char* unit =
+#ifdef POLYBENCH_CYCLE_ACCURATE_TIMER
+    "tsc_ticks";
+#else
+    "seconds";
+#endif
+  char kernel[256], host[256], date[32];
+  const char* variant;
+  const char* sep;
+  char** names = NULL;
+  long long* values = NULL;
+  int nb_counters = 0;
+  int cpus[POLYBENCH_MAX_NB_THREADS];
+  int nb_threads, csv, i, padding = 0;
+  double min = 0, median = 0, mean = 0, stddev = 0, p95 = 0, cv = 0;
+  int timed = polybench_t_samples != NULL;
+  time_t now = time (NULL);
+  FILE* f;
+
+  if (path == NULL || *path == '\0')
+    return;
+  csv = strlen (path) > 4 && ! strcasecmp (path + strlen (path) - 4, ".csv");
+  f = fopen (path, "a");
+  if (f == NULL)
+    {
+      fprintf (stderr, "[PolyBench][WARNING] cannot open %s: %s\n",
+	       path, strerror (errno));
+      return;
+    }
+
+  polybench_record_program (kernel, sizeof(kernel), &variant);
+  if (gethostname (host, sizeof(host)))
+    strcpy (host, "unknown");
+  host[sizeof(host) - 1] = '\0';
+  strftime (date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime (&now));
+  if (polybench_sizes_overridden)
+    dataset = "custom";
+#if defined(POLYBENCH_RUNTIME_PADDING)
+  padding = polybench_get_padding ();
+#elif defined(POLYBENCH_PADDING_FACTOR)
+  padding = POLYBENCH_PADDING_FACTOR;
+#endif
+  for (i = 0; i < 3; i++)
+    settings[i] = getenv (env[i]);
+#if defined(POLYBENCH_RUNTIME_SCHEDULE) && defined(_OPENMP)
+  settings[2] = polybench_schedule_name ();
+#endif
+  nb_threads = polybench_record_affinity (cpus);
+  if (timed)
+    {
+      polybench_timer_stats (&min, &median, &mean, &stddev, &p95);
+      cv = mean > 0 ? 100.0 * stddev / mean : 0;
+    }
+#ifdef POLYBENCH_PAPI
+  names = _polybench_papi_eventlist;
+  values = polybench_papi_values;
+  while (polybench_papi_eventlist[nb_counters] != 0)
+    nb_counters++;
+#endif
+#ifdef POLYBENCH_PERF
+  names = polybench_perf_eventlist;
+  values = polybench_perf_totals;
+  nb_counters = polybench_perf_nb_events;
+#endif
+
+  if (csv)
+    {
+      if (ftell (f) == 0)
+	fprintf (f, "date,host,kernel,variant,dataset,sizes,padding,threads,"
+		 "proc_bind,places,schedule,affinity,compiler,flags,"
+		 "instruments,unit,runs,warmup,min,median,mean,stddev,p95,"
+		 "cv,flops,bytes,counters,noise_before,noise_after,"
+		 "noise_retries\n");
+      fprintf (f, "%s,", date);
+      polybench_record_string (f, host, 1);
+      fputc (',', f);
+      polybench_record_string (f, kernel, 1);
+      fprintf (f, ",%s,%s,\"", variant, dataset);
+      for (i = 0; i < polybench_nb_sizes; i++)
+	fprintf (f, "%s%s=%d", i ? ";" : "", polybench_size_names[i],
+		 polybench_size_values[i]);
+      fprintf (f, "\",%d,%d", padding, nb_threads);
+      for (i = 0; i < 3; i++)
+	{
+	  fputc (',', f);
+	  polybench_record_string (f, settings[i], 1);
+	}
+      fputs (",\"", f);
+      for (i = 0; i < nb_threads; i++)
+	fprintf (f, "%s%d", i ? ";" : "", cpus[i]);
+      fputs ("\",", f);
+      polybench_record_string (f, POLYBENCH_COMPILER, 1);
+      fputc (',', f);
+      polybench_record_string (f, POLYBENCH_COMPILE_FLAGS, 1);
+      fprintf (f, ",\"%s\",%s,", instruments + (*instruments == ' '), unit);
+      if (timed)
+	fprintf (f, "%d,%d,%.9g,%.9g,%.9g,%.9g,%.9g,%.4f",
+		 polybench_nb_runs, polybench_nb_warmup,
+		 min, median, mean, stddev, p95, cv);
+      else
+	fputs (",,,,,,,", f);
+      fprintf (f, ",%.17g,%.17g,\"", polybench_program_total_flops,
+	       polybench_program_total_bytes);
+      for (i = 0, sep = ""; i < nb_counters; i++)
+	if (values[i] >= 0)
+	  {
+	    fprintf (f, "%s%s=%lld", sep, names[i], values[i]);
+	    sep = ";";
+	  }
+      fputc ('"', f);
+      if (polybench_noise)
+	fprintf (f, ",%.4f,%.4f,%d\n", polybench_noise_before,
+		 polybench_noise_after, polybench_noise_retry);
+      else
+	fputs (",,,\n", f);
+    }
+  else
+    {
+      fprintf (f, "{\"date\":\"%s\",\"host\":", date);
+      polybench_record_string (f, host, 0);
+      fputs (",\"kernel\":", f);
+      polybench_record_string (f, kernel, 0);
+      fprintf (f, ",\"variant\":\"%s\",\"dataset\":\"%s\",\"sizes\":{",
+	       variant, dataset);
+      for (i = 0; i < polybench_nb_sizes; i++)
+	fprintf (f, "%s\"%s\":%d", i ? "," : "", polybench_size_names[i],
+		 polybench_size_values[i]);
+      fprintf (f, "},\"padding\":%d,\"threads\":%d", padding, nb_threads);
+      for (i = 0; i < 3; i++)
+	{
+	  fprintf (f, ",\"%s\":", keys[i]);
+	  if (settings[i])
+	    polybench_record_string (f, settings[i], 0);
+	  else
+	    fputs ("null", f);
+	}
+      fputs (",\"affinity\":[", f);
+      for (i = 0; i < nb_threads; i++)
+	fprintf (f, "%s%d", i ? "," : "", cpus[i]);
+      fputs ("],\"compiler\":", f);
+      polybench_record_string (f, POLYBENCH_COMPILER, 0);
+      fputs (",\"flags\":", f);
+      polybench_record_string (f, POLYBENCH_COMPILE_FLAGS, 0);
+      fprintf (f, ",\"instruments\":\"%s\"", instruments + (*instruments == ' '));
+      if (timed)
+	{
+	  fprintf (f, ",\"unit\":\"%s\",\"runs\":%d,\"warmup\":%d,"
+		   "\"min\":%.9g,\"median\":%.9g,\"mean\":%.9g,"
+		   "\"stddev\":%.9g,\"p95\":%.9g,\"cv\":%.4f,\"samples\":[",
+		   unit, polybench_nb_runs, polybench_nb_warmup,
+		   min, median, mean, stddev, p95, cv);
+	  for (i = 0; i < polybench_nb_runs; i++)
+	    fprintf (f, "%s%.9g", i ? "," : "", polybench_t_samples[i]);
+	  fputc (']', f);
+	  if (polybench_noise)
+	    fprintf (f, ",\"noise\":{\"before\":%.4f,\"after\":%.4f,"
+		     "\"retries\":%d}", polybench_noise_before,
+		     polybench_noise_after, polybench_noise_retry);
+	}
+      fprintf (f, ",\"flops\":%.17g,\"bytes\":%.17g",
+	       polybench_program_total_flops, polybench_program_total_bytes);
+#ifdef POLYBENCH_ROOFLINE
+      fprintf (f, ",\"bandwidth\":%.3f,\"peak\":%.3f",
+	       polybench_roofline_bw, polybench_roofline_peak);
+#endif
+      fputs (",\"counters\":{", f);
+      for (i = 0; i < nb_counters; i++)
+	{
+	  fprintf (f, "%s\"%s\":", i ? "," : "", names[i]);
+	  if (values[i] >= 0)
+	    fprintf (f, "%lld", values[i]);
+	  else
+	    fputs ("null", f);
+	}
+      fputs ("}}\n", f);
+    }
+  fclose (f);
+}
+
+
+/* Output verification, selected with POLYBENCH_VERIFY:
+   "checksum" prints a checksum of each output array, "save:<file>"
+   stores the arrays in <file> (in binary) and "compare:<file>" compares
+   them with the ones stored in <file>. The reference is saved by the
+   sequential variant, or by the same binary with OMP_NUM_THREADS=1.
+   Two elements match if they are at most POLYBENCH_VERIFY_ULPS units in
+   the last place apart (default: 4), or if their relative difference is
+   at most POLYBENCH_VERIFY_RTOL (default: 1e-4 for float, 1e-10 for
+   double) or their absolute difference at most POLYBENCH_VERIFY_ATOL
+   (default: 0). A mismatch exits with status 1. */
+#define POLYBENCH_VERIFY_NAME_LEN 64
+
+struct polybench_verify_header
+{
+  char name[POLYBENCH_VERIFY_NAME_LEN];
+  long long elt_size;
+  long long rows;
+  long long cols;
+};
+
+int polybench_verify_saved = 0;
+
+
+static
+unsigned long long polybench_hash(const unsigned char* p, size_t len,
+				  unsigned long long h)
+{
+  size_t i;
+  for (i = 0; i < len; i++)
+    h = (h ^ p[i]) * 0x100000001b3ULL;
+  return h;
+}
+
+
+static
+double polybench_verify_value(const char* p, int elt_size)
+{
+  if (elt_size == sizeof(float))
+    return *(const float*) p;
+  return *(const double*) p;
+}
+
+
+/* Distance in units in the last place, on the ordered integer
+   representation of the floating-point values. */
+static
+long long polybench_verify_ulps(const char* a, const char* b, int elt_size)
+{
+  long long x, y;
+
+  if (elt_size == sizeof(float))
+    {
+      int fx, fy;
+      memcpy (&fx, a, sizeof(int));
+      memcpy (&fy, b, sizeof(int));
+      x = fx < 0 ? (long long) INT_MIN - fx : fx;
+      y = fy < 0 ? (long long) INT_MIN - fy : fy;
+    }
+  else
+    {
+      memcpy (&x, a, sizeof(long long));
+      memcpy (&y, b, sizeof(long long));
+      x = x < 0 ? LLONG_MIN - x : x;
+      y = y < 0 ? LLONG_MIN - y : y;
+      if ((x < 0) != (y < 0))
+	return LLONG_MAX;
+    }
+  return x > y ? x - y : y - x;
+}
+
+
+static
+void polybench_verify_checksum(const char* name, const char* data,
+			       int elt_size, long long rows, long long cols,
+			       size_t row_bytes)
+{
+  unsigned long long hash = 0;
+  double* sums = (double*) malloc (rows * sizeof(double));
+  double sum = 0;
+  long long i;
+
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:hash) schedule(static)
+#endif
+  for (i = 0; i < rows; i++)
+    {
+      const char* row = data + i * row_bytes;
+      long long j;
+      double s = 0;
+      /* Each row is hashed with its index, and the rows are combined
+	 with an addition, so that the hash does not depend on the
+	 number of threads. */
+      hash += polybench_hash ((const unsigned char*) row, cols * elt_size,
+			      0xcbf29ce484222325ULL ^ (unsigned long long) i);
+      for (j = 0; j < cols; j++)
+	s += polybench_verify_value (row + j * elt_size, elt_size);
+      sums[i] = s;
+    }
+  for (i = 0; i < rows; i++)
+    sum += sums[i];
+  free (sums);
+  printf ("[PolyBench] checksum %s: %016llx sum=%.9e\n", name, hash, sum);
+}
+
+
+static
+void polybench_verify_save(const char* path, const char* name,
+			   const char* data, int elt_size, long long rows,
+			   long long cols, size_t row_bytes)
+{
+  struct polybench_verify_header header;
+  FILE* f = fopen (path, polybench_verify_saved ? "a" : "w");
+  long long i;
+
+  if (f == NULL)
+    {
+      fprintf (stderr, "[PolyBench] cannot write %s: %s\n", path,
+	       strerror (errno));
+      exit (1);
+    }
+  memset (&header, 0, sizeof(header));
+  strncpy (header.name, name, POLYBENCH_VERIFY_NAME_LEN - 1);
+  header.elt_size = elt_size;
+  header.rows = rows;
+  header.cols = cols;
+  fwrite (&header, sizeof(header), 1, f);
+  for (i = 0; i < rows; i++)
+    fwrite (data + i * row_bytes, elt_size, cols, f);
+  if (fclose (f))
+    {
+      fprintf (stderr, "[PolyBench] cannot write %s: %s\n", path,
+	       strerror (errno));
+      exit (1);
+    }
+  polybench_verify_saved = 1;
+  printf ("[PolyBench] saved %s to %s\n", name, path);
+}
+
+
+static
+void polybench_verify_compare(const char* path, const char* name,
+			      const char* data, int elt_size, long long rows,
+			      long long cols, size_t row_bytes)
+{
+  struct polybench_verify_header header;
+  FILE* f = fopen (path, "r");
+  char* ref;
+  long long nb_errors = 0, first = LLONG_MAX, max_ulps = 0, i;
+  long long max_allowed_ulps = polybench_getenv_int ("POLYBENCH_VERIFY_ULPS", 4);
+  double rtol = polybench_getenv_double ("POLYBENCH_VERIFY_RTOL",
+					 elt_size == sizeof(float) ? 1e-4 : 1e-10);
+  double atol = polybench_getenv_double ("POLYBENCH_VERIFY_ATOL", 0);
+  double max_rel = 0;
+
+  if (f == NULL)
+    {
+      fprintf (stderr, "[PolyBench] cannot read %s: %s\n", path,
+	       strerror (errno));
+      exit (1);
+    }
+  while (fread (&header, sizeof(header), 1, f) == 1)
+    {
+      if (! strncmp (header.name, name, POLYBENCH_VERIFY_NAME_LEN - 1))
+	break;
+      fseek (f, header.elt_size * header.rows * header.cols, SEEK_CUR);
+      header.name[0] = '\0';
+    }
+  if (strncmp (header.name, name, POLYBENCH_VERIFY_NAME_LEN - 1))
+    {
+      fprintf (stderr, "[PolyBench] %s not found in %s\n", name, path);
+      exit (1);
+    }
+  if (header.elt_size != elt_size || header.rows != rows
+      || header.cols != cols)
+    {
+      fprintf (stderr, "[PolyBench] verify %s: FAILED, reference is "
+	       "%lldx%lld of %lld bytes, output is %lldx%lld of %d bytes\n",
+	       name, header.rows, header.cols, header.elt_size,
+	       rows, cols, elt_size);
+      exit (1);
+    }
+  ref = (char*) malloc (rows * cols * elt_size);
+  if (ref == NULL
+      || fread (ref, elt_size, rows * cols, f) != (size_t) (rows * cols))
+    {
+      fprintf (stderr, "[PolyBench] cannot read %s from %s\n", name, path);
+      exit (1);
+    }
+  fclose (f);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) reduction(+:nb_errors) \
+  reduction(min:first) reduction(max:max_ulps,max_rel)
+#endif
+  for (i = 0; i < rows; i++)
+    {
+      long long j;
+      for (j = 0; j < cols; j++)
+	{
+	  const char* a = data + i * row_bytes + j * elt_size;
+	  const char* b = ref + (i * cols + j) * elt_size;
+	  double x = polybench_verify_value (a, elt_size);
+	  double y = polybench_verify_value (b, elt_size);
+	  double diff = fabs (x - y);
+	  double scale = fmax (fabs (x), fabs (y));
+	  double rel = scale > 0 ? diff / scale : 0;
+	  long long ulps = polybench_verify_ulps (a, b, elt_size);
+	  if (isnan (x) && isnan (y))
+	    continue;
+	  if (rel > max_rel)
+	    max_rel = rel;
+	  if (ulps > max_ulps)
+	    max_ulps = ulps;
+	  if (ulps > max_allowed_ulps && ! (diff <= rtol * scale)
+	      && ! (diff <= atol))
+	    {
+	      nb_errors++;
+	      if (i * cols + j < first)
+		first = i * cols + j;
+	    }
+	}
+    }
+
+  if (nb_errors == 0)
+    printf ("[PolyBench] verify %s: OK (max ulps=%lld, max rel. error=%.3e)\n",
+	    name, max_ulps, max_rel);
+  else
+    {
+      long long fi = first / cols, fj = first % cols;
+      printf ("[PolyBench] verify %s: FAILED, %lld of %lld elements differ, "
+	      "first at [%lld][%lld]: %.9e instead of %.9e\n",
+	      name, nb_errors, rows * cols, fi, fj,
+	      polybench_verify_value (data + fi * row_bytes + fj * elt_size,
+				      elt_size),
+	      polybench_verify_value (ref + first * elt_size, elt_size));
+      free (ref);
+      exit (1);
+    }
+  free (ref);
+}
+
+
+void polybench_verify(const char* name, void* data, int elt_size,
+		      long long rows, long long cols, long long ld)
+{
+  const char* mode = getenv ("POLYBENCH_VERIFY");
+  size_t row_bytes = (size_t) ld * elt_size;
+
+  if (mode == NULL || *mode == '\0')
+    return;
+  if (elt_size != sizeof(float) && elt_size != sizeof(double))
+    {
+      fprintf (stderr, "[PolyBench] verify %s: unsupported element size %d\n",
+	       name, elt_size);
+      exit (1);
+    }
+  if (! strcmp (mode, "checksum"))
+    polybench_verify_checksum (name, data, elt_size, rows, cols, row_bytes);
+  else if (! strncmp (mode, "save:", 5))
+    polybench_verify_save (mode + 5, name, data, elt_size, rows, cols,
+			   row_bytes);
+  else if (! strncmp (mode, "compare:", 8))
+    polybench_verify_compare (mode + 8, name, data, elt_size, rows, cols,
+			      row_bytes);
+  else
+    {
+      fprintf (stderr, "[PolyBench] invalid POLYBENCH_VERIFY=%s\n", mode);
+      exit (1);
+    }
+}
+
+
+#ifdef POLYBENCH_TRACE
+/* Region tracer. polybench_region_begin/end record, in a ring buffer of
+   the calling OpenMP thread, the time stamp counter and the region.
+   The buffers are merged at exit into a Paraver trace <prefix>.prv,
+   <prefix>.pcf and <prefix>.row, where <prefix> is POLYBENCH_TRACE
+   (default: the program name). The regions begun inside an OpenMP
+   parallel region are events of type 60000018 (executed OpenMP parallel
+   function, as with Extrae), the others of type 90000001 (user region);
+   the threads are Running inside a region and Idle outside, except the
+   master thread. Each buffer keeps the last POLYBENCH_TRACE_BUFFER
+   events (default: 1048576) of its thread. The tasks begun with
+   polybench_task_begin are events of type 60000023 (executing OpenMP
+   task function), and the edges of polybench_task_edge communications
+   between the tasks of the same timed run. */
+# if defined(__x86_64__) || defined(__i386__)
+#  include <x86intrin.h>
+# endif
+# define POLYBENCH_TRACE_OMP_TYPE 60000018
+# define POLYBENCH_TRACE_TASK_TYPE 60000023
+# define POLYBENCH_TRACE_USER_TYPE 90000001
+# define POLYBENCH_TRACE_MAX_NB_REGIONS 256
+# define POLYBENCH_TRACE_MAX_DEPTH 64
+# define POLYBENCH_TRACE_BEGIN 1
+# define POLYBENCH_TRACE_OMP 2
+# define POLYBENCH_TRACE_TASK 4
+/* Task ids are unique within a timed run: the run is kept above them. */
+# define POLYBENCH_TRACE_RUN_SHIFT 40
+
+struct polybench_trace_event
+{
+  unsigned long long time;
+  long long task;
+  int region;
+  int flags;
+};
+
+struct polybench_trace_edge
+{
+  long long from;
+  long long to;
+};
+
+struct polybench_trace_buffer
+{
+  struct polybench_trace_event* events;
+  unsigned long long count;
+} __attribute__ ((aligned (64)));
+
+struct polybench_trace_buffer polybench_trace_buffers[POLYBENCH_MAX_NB_THREADS];
+unsigned long long polybench_trace_capacity = 1 << 20;
+const char* polybench_trace_names[POLYBENCH_TRACE_MAX_NB_REGIONS];
+int polybench_trace_nb_regions = 0;
+char polybench_trace_prefix[1024];
+unsigned long long polybench_trace_tsc0;
+double polybench_trace_ns0;
+long long polybench_trace_run_id = 0;
+struct polybench_trace_edge* polybench_trace_edges = NULL;
+unsigned long long polybench_trace_nb_edges = 0;
+unsigned long long polybench_trace_edges_capacity = 0;
+
+
+static inline
+unsigned long long polybench_trace_clock()
+{
+# if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc ();
+# else
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+# endif
+}
+
+
+static
+double polybench_trace_ns()
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+int polybench_trace_region(const char* name)
+{
+  int id;
+
+#ifdef _OPENMP
+#pragma omp critical (polybench_trace)
+#endif
+  {
+    for (id = 0; id < polybench_trace_nb_regions; id++)
+      if (! strcmp (polybench_trace_names[id], name))
+	break;
+    if (id == polybench_trace_nb_regions
+	&& polybench_trace_nb_regions < POLYBENCH_TRACE_MAX_NB_REGIONS)
+      polybench_trace_names[polybench_trace_nb_regions++] = name;
+  }
+  /* Value 0 ends the region in Paraver. */
+  return id < POLYBENCH_TRACE_MAX_NB_REGIONS ? id + 1 : 0;
+}
+
+
+/* A new timed run, for the task ids. */
+void polybench_trace_run()
+{
+  polybench_trace_run_id++;
+}
+
+
+static
+void polybench_trace_push(int region, int flags, long long task)
+{
+  int tid = 0;
+  struct polybench_trace_buffer* buf;
+  struct polybench_trace_event* e;
+
+#ifdef _OPENMP
+  tid = omp_get_thread_num ();
+  if (omp_in_parallel ())
+    flags |= POLYBENCH_TRACE_OMP;
+#endif
+  if (region == 0 || tid >= POLYBENCH_MAX_NB_THREADS)
+    return;
+  buf = &polybench_trace_buffers[tid];
+  if (buf->events == NULL)
+    {
+      buf->events = (struct polybench_trace_event*)
+	malloc (polybench_trace_capacity * sizeof(struct polybench_trace_event));
+      if (buf->events == NULL)
+	{
+	  fprintf (stderr, "[PolyBench] cannot allocate the trace buffer\n");
+	  exit (1);
+	}
+    }
+  e = &buf->events[buf->count++ & (polybench_trace_capacity - 1)];
+  e->time = polybench_trace_clock ();
+  e->task = task;
+  e->region = region;
+  e->flags = flags;
+}
+
+
+void polybench_trace_event(int region, int begin)
+{
+  polybench_trace_push (region, begin ? POLYBENCH_TRACE_BEGIN : 0, -1);
+}
+
+
+void polybench_trace_task(int region, long long id, int begin)
+{
+  polybench_trace_push (region,
+			POLYBENCH_TRACE_TASK | (begin ? POLYBENCH_TRACE_BEGIN : 0),
+			(polybench_trace_run_id << POLYBENCH_TRACE_RUN_SHIFT) | id);
+}
+
+
+void polybench_trace_edge(long long from, long long to)
+{
+  long long run = polybench_trace_run_id << POLYBENCH_TRACE_RUN_SHIFT;
+
+#ifdef _OPENMP
+#pragma omp critical (polybench_trace)
+#endif
+  {
+    if (polybench_trace_nb_edges == polybench_trace_edges_capacity)
+      {
+	unsigned long long capacity = polybench_trace_edges_capacity
+	  ? 2 * polybench_trace_edges_capacity : 4096;
+	struct polybench_trace_edge* edges = (struct polybench_trace_edge*)
+	  realloc (polybench_trace_edges,
+		   capacity * sizeof(struct polybench_trace_edge));
+	if (edges == NULL)
+	  {
+	    fprintf (stderr, "[PolyBench] cannot allocate the trace edges\n");
+	    exit (1);
+	  }
+	polybench_trace_edges = edges;
+	polybench_trace_edges_capacity = capacity;
+      }
+    polybench_trace_edges[polybench_trace_nb_edges].from = run | from;
+    polybench_trace_edges[polybench_trace_nb_edges++].to = run | to;
+  }
+}
+
+
+/* A record of the .prv file: a state (kind 1), an event (kind 2) or a
+   communication (kind 3) from thread at time to value at end. */
+struct polybench_trace_record
+{
+  unsigned long long time;
+  unsigned long long end;
+  int kind;
+  int thread;
+  int type;
+  int value;
+};
+
+
+/* The execution of a task, for its edges. */
+struct polybench_trace_task_record
+{
+  long long task;
+  unsigned long long begin;
+  unsigned long long end;
+  int thread;
+};
+
+
+static
+int polybench_trace_compare(const void* a, const void* b)
+{
+  const struct polybench_trace_record* x = a;
+  const struct polybench_trace_record* y = b;
+  if (x->time != y->time)
+    return x->time < y->time ? -1 : 1;
+  if (x->kind != y->kind)
+    return x->kind - y->kind;
+  return x->thread - y->thread;
+}
+
+
+static
+int polybench_trace_compare_task(const void* a, const void* b)
+{
+  const struct polybench_trace_task_record* x = a;
+  const struct polybench_trace_task_record* y = b;
+  return x->task < y->task ? -1 : x->task > y->task;
+}
+
+
+static
+struct polybench_trace_task_record*
+polybench_trace_find_task(struct polybench_trace_task_record* tasks,
+			  unsigned long long nb_tasks, long long task)
+{
+  struct polybench_trace_task_record key;
+
+  key.task = task;
+  return bsearch (&key, tasks, nb_tasks,
+		  sizeof(struct polybench_trace_task_record),
+		  polybench_trace_compare_task);
+}
+
+
+static
+void polybench_trace_write_pcf(const char* path)
+{
+  FILE* f = fopen (path, "w");
+  int i, t;
+  int types[3] = { POLYBENCH_TRACE_OMP_TYPE, POLYBENCH_TRACE_USER_TYPE,
+		   POLYBENCH_TRACE_TASK_TYPE };
+  const char* labels[3] = { "Executed OpenMP parallel function",
+			    "User region",
+			    "Executing OpenMP task function" };
+
+  if (f == NULL)
+    return;
+  fprintf (f, "DEFAULT_OPTIONS\n\n"
+	   "LEVEL               THREAD\n"
+	   "UNITS               NANOSEC\n"
+	   "LOOK_BACK           100\n"
+	   "SPEED               1\n"
+	   "FLAG_ICONS          ENABLED\n"
+	   "NUM_OF_STATE_COLORS 1000\n"
+	   "YMAX_SCALE          37\n\n\n"
+	   "DEFAULT_SEMANTIC\n\n"
+	   "THREAD_FUNC          State As Is\n\n\n"
+	   "STATES\n"
+	   "0    Idle\n"
+	   "1    Running\n"
+	   "2    Not created\n\n\n"
+	   "STATES_COLOR\n"
+	   "0    {117,195,255}\n"
+	   "1    {0,0,255}\n"
+	   "2    {255,255,255}\n\n\n");
+  for (t = 0; t < 3; t++)
+    {
+      fprintf (f, "EVENT_TYPE\n0    %d    %s\nVALUES\n0   End\n",
+	       types[t], labels[t]);
+      for (i = 0; i < polybench_trace_nb_regions; i++)
+	fprintf (f, "%d   %s\n", i + 1, polybench_trace_names[i]);
+      fprintf (f, "\n\n");
+    }
+  fclose (f);
+}
+
+
+static
+void polybench_trace_write_row(const char* path, const char* host,
+			       int nb_threads)
+{
+  FILE* f = fopen (path, "w");
+  int i;
+
+  if (f == NULL)
+    return;
+  fprintf (f, "LEVEL CPU SIZE %d\n", nb_threads);
+  for (i = 0; i < nb_threads; i++)
+    fprintf (f, "%d.%s\n", i + 1, host);
+  fprintf (f, "\nLEVEL NODE SIZE 1\n%s\n\n", host);
+  fprintf (f, "LEVEL THREAD SIZE %d\n", nb_threads);
+  for (i = 0; i < nb_threads; i++)
+    fprintf (f, "THREAD 1.1.%d\n", i + 1);
+  fclose (f);
+}
+
+
+static
+void polybench_trace_flush()
+{
+  double ratio, ns = polybench_trace_ns ();
+  unsigned long long tsc = polybench_trace_clock ();
+  unsigned long long end = (unsigned long long) (ns - polybench_trace_ns0);
+  unsigned long long nb_records = 0, dropped = 0, r, k;
+  unsigned long long nb_tasks = 0;
+  struct polybench_trace_record* records;
+  struct polybench_trace_task_record* tasks;
+  int types[3] = { POLYBENCH_TRACE_USER_TYPE, POLYBENCH_TRACE_OMP_TYPE,
+		   POLYBENCH_TRACE_TASK_TYPE };
+  int nb_threads = 0, tid;
+  char path[1100], host[256], date[32];
+  time_t now = time (NULL);
+  FILE* f;
+
+  ratio = tsc > polybench_trace_tsc0
+    ? (ns - polybench_trace_ns0) / (double) (tsc - polybench_trace_tsc0) : 1;
+  for (tid = 0; tid < POLYBENCH_MAX_NB_THREADS; tid++)
+    if (polybench_trace_buffers[tid].count)
+      {
+	unsigned long long count = polybench_trace_buffers[tid].count;
+	if (count > polybench_trace_capacity)
+	  count = polybench_trace_capacity;
+	nb_threads = tid + 1;
+	nb_records += 2 * count + 2;
+      }
+  if (nb_threads == 0)
+    return;
+  records = (struct polybench_trace_record*)
+    calloc (nb_records + polybench_trace_nb_edges,
+	    sizeof(struct polybench_trace_record));
+  tasks = (struct polybench_trace_task_record*)
+    calloc (nb_records / 2, sizeof(struct polybench_trace_task_record));
+  if (records == NULL || tasks == NULL)
+    {
+      fprintf (stderr, "[PolyBench] cannot allocate the trace records\n");
+      free (records);
+      free (tasks);
+      return;
+    }
+
+  /* Convert the events of each thread, with the states between them. */
+  r = 0;
+  for (tid = 0; tid < nb_threads; tid++)
+    {
+      struct polybench_trace_buffer* buf = &polybench_trace_buffers[tid];
+      int stack[3][POLYBENCH_TRACE_MAX_DEPTH];
+      unsigned long long task_stack[POLYBENCH_TRACE_MAX_DEPTH];
+      int depth[3] = { 0, 0, 0 };
+      unsigned long long first = 0, last = 0;
+      int running = (tid == 0);
+
+      if (buf->count > polybench_trace_capacity)
+	{
+	  first = buf->count - polybench_trace_capacity;
+	  dropped += first;
+	}
+      for (k = first; k < buf->count; k++)
+	{
+	  struct polybench_trace_event* e =
+	    &buf->events[k & (polybench_trace_capacity - 1)];
+	  unsigned long long t = e->time > polybench_trace_tsc0
+	    ? (unsigned long long) ((e->time - polybench_trace_tsc0) * ratio) : 0;
+	  int cls = e->flags & POLYBENCH_TRACE_TASK ? 2
+	    : (e->flags & POLYBENCH_TRACE_OMP) != 0;
+	  int value;
+
+	  if (t > end)
+	    t = end;
+	  if (e->flags & POLYBENCH_TRACE_BEGIN)
+	    {
+	      if (depth[cls] < POLYBENCH_TRACE_MAX_DEPTH)
+		{
+		  stack[cls][depth[cls]] = e->region;
+		  if (cls == 2)
+		    {
+		      /* Tied tasks nest on their thread. */
+		      task_stack[depth[cls]] = nb_tasks;
+		      tasks[nb_tasks].task = e->task;
+		      tasks[nb_tasks].begin = tasks[nb_tasks].end = t;
+		      tasks[nb_tasks++].thread = tid;
+		    }
+		}
+	      depth[cls]++;
+	      value = e->region;
+	    }
+	  else
+	    {
+	      /* Back to the enclosing region of the same type. */
+	      if (depth[cls] > 0
+		  && --depth[cls] < POLYBENCH_TRACE_MAX_DEPTH && cls == 2)
+		tasks[task_stack[depth[cls]]].end = t;
+	      value = depth[cls] > 0 && depth[cls] <= POLYBENCH_TRACE_MAX_DEPTH
+		? stack[cls][depth[cls] - 1] : 0;
+	    }
+	  records[r].time = t;
+	  records[r].kind = 2;
+	  records[r].thread = tid;
+	  records[r].type = types[cls];
+	  records[r++].value = value;
+
+	  /* The worker threads are Running inside a region only. */
+	  if (tid > 0 && running != (depth[0] + depth[1] + depth[2] > 0))
+	    {
+	      records[r].time = last;
+	      records[r].end = t;
+	      records[r].kind = 1;
+	      records[r].thread = tid;
+	      records[r++].value = k == first ? 2 : running;
+	      running = ! running;
+	      last = t;
+	    }
+	}
+      records[r].time = last;
+      records[r].end = end;
+      records[r].kind = 1;
+      records[r].thread = tid;
+      records[r++].value = running || tid == 0 ? 1 : (last ? 0 : 2);
+    }
+
+  /* The edges between tasks traced in full. */
+  qsort (tasks, nb_tasks, sizeof(struct polybench_trace_task_record),
+	 polybench_trace_compare_task);
+  for (k = 0; k < polybench_trace_nb_edges; k++)
+    {
+      struct polybench_trace_task_record* from =
+	polybench_trace_find_task (tasks, nb_tasks,
+				   polybench_trace_edges[k].from);
+      struct polybench_trace_task_record* to =
+	polybench_trace_find_task (tasks, nb_tasks,
+				   polybench_trace_edges[k].to);
+      if (from == NULL || to == NULL)
+	continue;
+      records[r].time = from->end;
+      records[r].end = to->begin > from->end ? to->begin : from->end;
+      records[r].kind = 3;
+      records[r].thread = from->thread;
+      records[r++].value = to->thread;
+    }
+  free (tasks);
+  qsort (records, r, sizeof(struct polybench_trace_record),
+	 polybench_trace_compare);
+  if (dropped)
+    fprintf (stderr, "[PolyBench][WARNING] %llu trace events dropped, "
+	     "increase POLYBENCH_TRACE_BUFFER\n", dropped);
+
+  snprintf (path, sizeof(path), "%s.prv", polybench_trace_prefix);
+  f = fopen (path, "w");
+  if (f == NULL)
+    {
+      fprintf (stderr, "[PolyBench] cannot write %s: %s\n", path,
+	       strerror (errno));
+      free (records);
+      return;
+    }
+  strftime (date, sizeof(date), "%d/%m/%Y at %H:%M", localtime (&now));
+  fprintf (f, "#Paraver (%s):%llu_ns:1(%d):1:1(%d:1),0\n",
+	   date, end, nb_threads, nb_threads);
+  for (k = 0; k < r; k++)
+    if (records[k].kind == 1)
+      {
+	if (records[k].end > records[k].time)
+	  fprintf (f, "1:%d:1:1:%d:%llu:%llu:%d\n", records[k].thread + 1,
+		   records[k].thread + 1, records[k].time, records[k].end,
+		   records[k].value);
+      }
+    else if (records[k].kind == 2)
+      fprintf (f, "2:%d:1:1:%d:%llu:%d:%d\n", records[k].thread + 1,
+	       records[k].thread + 1, records[k].time, records[k].type,
+	       records[k].value);
+    else
+      fprintf (f, "3:%d:1:1:%d:%llu:%llu:%d:1:1:%d:%llu:%llu:0:0\n",
+	       records[k].thread + 1, records[k].thread + 1,
+	       records[k].time, records[k].time, records[k].value + 1,
+	       records[k].value + 1, records[k].end, records[k].end);
+  fclose (f);
+  free (records);
+
+  if (gethostname (host, sizeof(host)))
+    strcpy (host, "localhost");
+  host[sizeof(host) - 1] = '\0';
+  snprintf (path, sizeof(path), "%s.pcf", polybench_trace_prefix);
+  polybench_trace_write_pcf (path);
+  snprintf (path, sizeof(path), "%s.row", polybench_trace_prefix);
+  polybench_trace_write_row (path, host, nb_threads);
+  fprintf (stderr, "[PolyBench] trace written to %s.prv\n",
+	   polybench_trace_prefix);
+}
+
+
+static __attribute__ ((constructor))
+void polybench_trace_init()
+{
+  const char* prefix = getenv ("POLYBENCH_TRACE");
+  long long capacity = polybench_getenv_int ("POLYBENCH_TRACE_BUFFER", 1 << 20);
+
+  /* The ring buffers are indexed with a mask. */
+  polybench_trace_capacity = 1;
+  while ((long long) polybench_trace_capacity < capacity)
+    polybench_trace_capacity <<= 1;
+  if (prefix == NULL || *prefix == '\0')
+#ifdef __GLIBC__
+    prefix = program_invocation_short_name;
+#else
+    prefix = "polybench";
+#endif
+  snprintf (polybench_trace_prefix, sizeof(polybench_trace_prefix), "%s",
+	    prefix);
+  polybench_trace_ns0 = polybench_trace_ns ();
+  polybench_trace_tsc0 = polybench_trace_clock ();
+  atexit (polybench_trace_flush);
+}
+#endif
+
+
+/* Allocation policies, selected with POLYBENCH_ALLOC_POLICY:
+   "default" (posix_memalign only), "firsttouch" (pages are touched by
+   the OpenMP threads with a static schedule, as the kernels partition
+   their rows), "interleave" (pages interleaved across all the online
+   NUMA nodes) or "bind:<nodes>" (pages bound to a node list such as
+   "0" or "0-1"). POLYBENCH_ALIGNMENT gives the alignment in bytes, or
+   "page"; POLYBENCH_THP=1 requests transparent huge pages. */
+#define POLYBENCH_ALLOC_DEFAULT 0
+#define POLYBENCH_ALLOC_FIRSTTOUCH 1
+#define POLYBENCH_ALLOC_INTERLEAVE 2
+#define POLYBENCH_ALLOC_BIND 3
+#define POLYBENCH_MAX_NUMNODES 1024
+#define POLYBENCH_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#ifndef MPOL_BIND
+# define MPOL_BIND 2
+# define MPOL_INTERLEAVE 3
+#endif
+
+int polybench_alloc_policy = -1;
+size_t polybench_alignment = 64;
+int polybench_thp = 0;
+unsigned long polybench_nodemask[POLYBENCH_MAX_NUMNODES / (8 * sizeof(unsigned long))];
+
+
+/* Parse a Linux list such as "0-3,8,10-11" into a bit mask. */
+static
+int polybench_parse_list(const char* list, unsigned long* mask, int nbits)
+{
+  const int bits = 8 * sizeof(unsigned long);
+  const char* p = list;
+  int count = 0;
+
+  memset (mask, 0, nbits / 8);
+  while (*p)
+    {
+      char* end;
+      long lo = strtol (p, &end, 10), hi, i;
+      if (end == p)
+	break;
+      hi = lo;
+      if (*end == '-')
+	{
+	  p = end + 1;
+	  hi = strtol (p, &end, 10);
+	}
+      for (i = lo; i <= hi && i < nbits; i++, count++)
+	mask[i / bits] |= 1UL << (i % bits);
+      p = *end == ',' ? end + 1 : end;
+      if (*end != ',')
+	break;
+    }
+  return count;
+}
+
+
+static
+void polybench_alloc_init()
+{
+  const char* policy = getenv ("POLYBENCH_ALLOC_POLICY");
+  const char* align = getenv ("POLYBENCH_ALIGNMENT");
+  size_t page = sysconf (_SC_PAGESIZE);
+
+  polybench_alloc_policy = POLYBENCH_ALLOC_DEFAULT;
+  polybench_thp = polybench_getenv_int ("POLYBENCH_THP", 0);
+  if (align && ! strcmp (align, "page"))
+    polybench_alignment = page;
+  else if (align && *align)
+    polybench_alignment = strtoul (align, NULL, 10);
+  if (polybench_alignment < sizeof(void*)
+      || (polybench_alignment & (polybench_alignment - 1)))
+    {
+      fprintf (stderr, "[PolyBench] invalid POLYBENCH_ALIGNMENT: %s\n", align);
+      exit (1);
+    }
+
+  if (policy == NULL || *policy == '\0' || ! strcmp (policy, "default"))
+    ;
+  else if (! strcmp (policy, "firsttouch"))
+    polybench_alloc_policy = POLYBENCH_ALLOC_FIRSTTOUCH;
+  else if (! strcmp (policy, "interleave"))
+    {
+      char online[256] = "0";
+      FILE* f = fopen ("/sys/devices/system/node/online", "r");
+      if (f)
+	{
+	  if (! fgets (online, sizeof(online), f))
+	    strcpy (online, "0");
+	  fclose (f);
+	}
+      polybench_parse_list (online, polybench_nodemask,
+			    POLYBENCH_MAX_NUMNODES);
+      polybench_alloc_policy = POLYBENCH_ALLOC_INTERLEAVE;
+    }
+  else if (! strncmp (policy, "bind:", 5)
+	   && polybench_parse_list (policy + 5, polybench_nodemask,
+				    POLYBENCH_MAX_NUMNODES) > 0)
+    polybench_alloc_policy = POLYBENCH_ALLOC_BIND;
+  else
+    {
+      fprintf (stderr, "[PolyBench] invalid POLYBENCH_ALLOC_POLICY: %s\n",
+	       policy);
+      exit (1);
+    }
+
+  /* mbind and madvise work on whole pages. */
+  if (polybench_alloc_policy >= POLYBENCH_ALLOC_INTERLEAVE
+      && polybench_alignment < page)
+    polybench_alignment = page;
+  if (polybench_thp && polybench_alignment < POLYBENCH_HUGE_PAGE_SIZE)
+    polybench_alignment = POLYBENCH_HUGE_PAGE_SIZE;
+}
+
+
+/* Apply the allocation policy to a fresh allocation, before any page
+   of it is touched. */
+static
+void polybench_alloc_place(void* ptr, size_t num)
+{
+  long page = sysconf (_SC_PAGESIZE);
+  long offset = (size_t) ptr % page;
+  long npages = (num + offset + page - 1) / page;
+  long p;
+  char* data = (char*) ptr - offset;
+
+#ifdef __linux__
+  if (polybench_thp)
+    {
+      size_t len = (num + offset + POLYBENCH_HUGE_PAGE_SIZE - 1)
+	& ~((size_t) POLYBENCH_HUGE_PAGE_SIZE - 1);
+      if (madvise (data, len, MADV_HUGEPAGE))
+	perror ("[PolyBench] madvise");
+    }
+# ifdef __NR_mbind
+  if (polybench_alloc_policy >= POLYBENCH_ALLOC_INTERLEAVE)
+    {
+      int mode = polybench_alloc_policy == POLYBENCH_ALLOC_INTERLEAVE ?
+	MPOL_INTERLEAVE : MPOL_BIND;
+      if (syscall (__NR_mbind, data, npages * page, mode, polybench_nodemask,
+		   POLYBENCH_MAX_NUMNODES + 1, 0))
+	perror ("[PolyBench] mbind");
+    }
+# endif
+#endif
+  if (polybench_alloc_policy == POLYBENCH_ALLOC_DEFAULT)
+    return;
+  /* Fault the pages in from the OpenMP threads, with the static
+     schedule the kernels use over their rows. The first page is
+     touched through ptr: outside the arena, [data, ptr) may belong to
+     another heap object. */
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (p = 0; p < npages; p++)
+    *(p == 0 ? (char*) ptr : data + p * page) = 0;
+}
+
+
+static
+void *
+xmalloc (size_t num)
+{
+  void* new = NULL;
+  int ret;
+  if (polybench_alloc_policy < 0)
+    polybench_alloc_init ();
+  ret = posix_memalign (&new, polybench_alignment, num);
+  if (! new || ret)
+    {
+      fprintf (stderr, "[PolyBench] posix_memalign: cannot allocate memory");
+      exit (1);
+    }
+  polybench_alloc_place (new, num);
+  return new;
+}
+
+
+/* Arena. By default, the arrays are carved from a single mapping,
+   reserved once with the size of the physical memory (its pages are
+   only backed when touched) and aligned on a huge page. Array k starts
+   k * POLYBENCH_ARENA_STAGGER cache lines (default: 1, modulo a page)
+   past a page boundary, so that the arrays of a kernel do not start on
+   the same cache sets. The arena is a stack: freeing the top array (or
+   an array under which all the others are already freed) rewinds it,
+   and the next allocations reuse its pages, already faulted in. With an
+   allocation policy, the reused pages are dropped first, so that they
+   are placed again (bound, interleaved or first-touched) as new ones.
+   POLYBENCH_ARENA=0 allocates each array with posix_memalign instead. */
+struct polybench_arena_array
+{
+  size_t start;
+  size_t top;
+  int freed;
+};
+
+int polybench_arena_enabled = -1;
+char* polybench_arena = NULL;
+size_t polybench_arena_size = 0;
+size_t polybench_arena_top = 0;
+size_t polybench_arena_high = 0;
+size_t polybench_arena_stagger = 64;
+struct polybench_arena_array* polybench_arena_arrays = NULL;
+int polybench_arena_nb_arrays = 0;
+int polybench_arena_capacity = 0;
+
+
+static
+void polybench_arena_init()
+{
+  size_t line = 64;
+  char buf[32];
+  long pages = sysconf (_SC_PHYS_PAGES);
+  size_t page = sysconf (_SC_PAGESIZE);
+
+  polybench_arena_enabled = polybench_getenv_int ("POLYBENCH_ARENA", 1);
+  if (! polybench_arena_enabled)
+    return;
+  if (polybench_read_sysfs ("/sys/devices/system/cpu/cpu0/cache/index0/"
+			    "coherency_line_size", buf, sizeof(buf))
+      && atoi (buf) > 0)
+    line = atoi (buf);
+  polybench_arena_stagger =
+    line * polybench_getenv_int ("POLYBENCH_ARENA_STAGGER", 1);
+#ifdef MAP_NORESERVE
+  if (pages > 0)
+    {
+      size_t size = (size_t) pages * page + POLYBENCH_HUGE_PAGE_SIZE;
+      char* base = (char*) mmap (NULL, size, PROT_READ | PROT_WRITE,
+				 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+				 -1, 0);
+      if (base != MAP_FAILED)
+	{
+	  size_t skip = (POLYBENCH_HUGE_PAGE_SIZE
+			 - (size_t) base % POLYBENCH_HUGE_PAGE_SIZE)
+	    % POLYBENCH_HUGE_PAGE_SIZE;
+	  polybench_arena = base + skip;
+	  polybench_arena_size = size - skip;
+	  return;
+	}
+    }
+#endif
+  /* No reservation: fall back to posix_memalign. */
+  polybench_arena_enabled = 0;
+}
+
+
+static
+void* polybench_arena_alloc(size_t num)
+{
+  size_t page = sysconf (_SC_PAGESIZE);
+  size_t start = (polybench_arena_top + page - 1) & ~(page - 1);
+
+  /* Stagger the start of the array within its page, unless the arrays
+     must be aligned on pages. */
+  if (polybench_alignment < page)
+    start += (polybench_arena_nb_arrays * polybench_arena_stagger) % page;
+  start = (start + polybench_alignment - 1) & ~(polybench_alignment - 1);
+  if (start > polybench_arena_size || num > polybench_arena_size - start)
+    {
+      fprintf (stderr, "[PolyBench] cannot allocate %zu bytes: "
+	       "the arena is full\n", num);
+      exit (1);
+    }
+  if (polybench_arena_nb_arrays == polybench_arena_capacity)
+    {
+      int capacity = polybench_arena_capacity ? 2 * polybench_arena_capacity : 64;
+      struct polybench_arena_array* arrays = (struct polybench_arena_array*)
+	realloc (polybench_arena_arrays,
+		 capacity * sizeof(struct polybench_arena_array));
+      if (arrays == NULL)
+	{
+	  fprintf (stderr, "[PolyBench] cannot allocate the arena stack\n");
+	  exit (1);
+	}
+      polybench_arena_arrays = arrays;
+      polybench_arena_capacity = capacity;
+    }
+  polybench_arena_arrays[polybench_arena_nb_arrays].start = start;
+  polybench_arena_arrays[polybench_arena_nb_arrays].top = polybench_arena_top;
+  polybench_arena_arrays[polybench_arena_nb_arrays++].freed = 0;
+  polybench_arena_top = start + num;
+
+#ifdef MADV_DONTNEED
+  /* Pages faulted in by a freed array would keep their placement. The
+     first page of the array starts past the previous top, so that no
+     live array shares them. */
+  if (polybench_alloc_policy != POLYBENCH_ALLOC_DEFAULT
+      && start < polybench_arena_high)
+    {
+      size_t first = start & ~(page - 1);
+      size_t last = polybench_arena_top < polybench_arena_high
+	? polybench_arena_top : polybench_arena_high;
+      last = (last + page - 1) & ~(page - 1);
+      if (madvise (polybench_arena + first, last - first, MADV_DONTNEED))
+	perror ("[PolyBench] madvise");
+    }
+#endif
+  if (polybench_arena_top > polybench_arena_high)
+    polybench_arena_high = polybench_arena_top;
+  polybench_alloc_place (polybench_arena + start, num);
+  return polybench_arena + start;
+}
+
+
+void* polybench_alloc_data(unsigned long long int n, size_t elt_size)
+{
+  size_t val = n;
+
+  if (val != n || (elt_size && val > SIZE_MAX / elt_size))
+    {
+      fprintf (stderr, "[PolyBench] cannot allocate %llu elements of %zu "
+	       "bytes: size overflow\n", n, elt_size);
+      exit (1);
+    }
+  val *= elt_size;
+  if (polybench_alloc_policy < 0)
+    polybench_alloc_init ();
+  if (polybench_arena_enabled < 0)
+    polybench_arena_init ();
+  if (polybench_arena_enabled)
+    return polybench_arena_alloc (val);
+  return xmalloc (val);
+}
+
+
+void polybench_free_data(void* ptr)
+{
+  char* data = (char*) ptr;
+  int k;
+
+  if (ptr == NULL)
+    return;
+  if (polybench_arena == NULL || data < polybench_arena
+      || data >= polybench_arena + polybench_arena_size)
+    {
+      free (ptr);
+      return;
+    }
+  for (k = polybench_arena_nb_arrays - 1; k >= 0; k--)
+    if (polybench_arena + polybench_arena_arrays[k].start == data)
+      {
+	polybench_arena_arrays[k].freed = 1;
+	break;
+      }
+  /* Pop the freed arrays from the top of the stack. */
+  while (polybench_arena_nb_arrays > 0
+	 && polybench_arena_arrays[polybench_arena_nb_arrays - 1].freed)
+    polybench_arena_top =
+      polybench_arena_arrays[--polybench_arena_nb_arrays].top;
 }
@@ -16,6 +16,93 @@
  *   OR (exclusive):
  * -DPOLYBENCH_PAPI, to use PAPI H/W counters (defined in polybench.c)
  *
+ * -DPOLYBENCH_GFLOPS, to report GFLOP/s instead of the time, from the
+ *   flop count given with polybench_set_program_flops.
+ *
+ * -DPOLYBENCH_ROOFLINE, with -DPOLYBENCH_TIME or -DPOLYBENCH_GFLOPS, to
+ *   also report the arithmetic intensity of the kernel and how far it is
+ *   from the roofline of the host. The memory bandwidth and the peak
+ *   flop rate are measured once per host and thread count, and cached in
+ *   POLYBENCH_ROOFLINE_CACHE (default: $HOME/.polybench_roofline).
+ *
+ * By default, the PAPI events of papi_counters.list are counted together
+ * on every OpenMP thread during a single run of the kernel (multiplexed
+ * if they do not fit in the hardware counters). Define
+ * -DPOLYBENCH_PAPI_SERIALIZE to run the kernel once per event instead,
+ * on thread POLYBENCH_THREAD_MONITOR only.
+ *
+ * The heap arrays are placed according to POLYBENCH_ALLOC_POLICY
+ * (default, firsttouch, interleave or bind:<nodes>), aligned on
+ * POLYBENCH_ALIGNMENT bytes (default: 64, or "page") and backed by
+ * transparent huge pages with POLYBENCH_THP=1 (see polybench.c). They
+ * are carved from a single arena, at staggered cache lines, and the
+ * arena is reused once they are freed; POLYBENCH_ARENA=0 allocates each
+ * array separately.
+ *
+ * -DPOLYBENCH_RUNTIME_PADDING, to choose the padding of the arrays at
+ *   run time with POLYBENCH_PADDING=<elements>, or "auto" to pad only
+ *   when the rows of an array would map to a few L1 sets.
+ *
+ * Before each timed run, the caches are flushed with a buffer sized from
+ * the cache topology in sysfs. POLYBENCH_CACHE=warm skips the flush to
+ * time warm-cache runs, and -DPOLYBENCH_NO_FLUSH_CACHE removes it.
+ *
+ * -DPOLYBENCH_PERF, to use the Linux perf_event_open counters instead of
+ *   PAPI. The events are read from POLYBENCH_PERF_EVENTS (comma
+ *   separated perf names, e.g. "cycles,instructions,page-faults"); by
+ *   default hardware events are used, or task-clock, page-faults,
+ *   context-switches and cpu-migrations when the PMU is not available.
+ *
+ * -DPOLYBENCH_CYCLE_ACCURATE_TIMER, with -DPOLYBENCH_TIME, to time the
+ *   runs with the serialized time stamp counter, reported in ticks and
+ *   in seconds (the TSC is calibrated against CLOCK_MONOTONIC_RAW, and
+ *   replaced by it when it is not invariant or POLYBENCH_TSC=0). The
+ *   ticks are those of the constant-rate TSC, not core clock cycles.
+ *   Inside a parallel region, polybench_thread_begin/end stamp each
+ *   thread around an "omp for nowait" loop: with POLYBENCH_STAMPS=1,
+ *   the timed runs then report the per-thread stamps and the arrival
+ *   skew at the next barrier on stderr.
+ *
+ * -DPOLYBENCH_RUNTIME_SCHEDULE, to run the worksharing loops of the
+ *   kernels with schedule(runtime), taken from OMP_SCHEDULE (see
+ *   schedsweep.sh to find the best schedule of a kernel).
+ *
+ * With -DPOLYBENCH_TIME, the following environment variables control
+ * the repetition mode (see polybench_repeat):
+ *
+ * POLYBENCH_REPETITIONS=n, number of timed runs (default: 1),
+ * POLYBENCH_WARMUP=n, number of untimed warm-up runs (default: 0),
+ * POLYBENCH_CV_THRESHOLD=p, coefficient of variation, in percent,
+ *   above which the timings are flagged as unreliable (default: 5),
+ * POLYBENCH_POP=1, to report the load balance, serialization and
+ *   parallel efficiencies of the OpenMP threads over the timed runs, from
+ *   their CPU times (run with OMP_WAIT_POLICY=passive, see
+ *   scalingsweep.sh for a sweep over thread counts and placements).
+ * POLYBENCH_NOISE=1, to measure the OS noise on every CPU before and
+ *   after the runs with a fixed-work-quantum probe, flag the host as
+ *   noisy above POLYBENCH_NOISE_THRESHOLD percent (default: 1) and
+ *   start the timed runs over up to POLYBENCH_NOISE_RETRIES times
+ *   (default: 0, see polybench.c for the other settings).
+ *
+ * -DPOLYBENCH_TRACE, to write a Paraver trace (.prv, .pcf and .row) of
+ *   the regions delimited by polybench_region_begin/end and of the timed
+ *   runs, without Extrae. POLYBENCH_TRACE gives the trace name (default:
+ *   the program name). The OpenMP tasks delimited by
+ *   polybench_task_begin/end are traced as well, with the dependencies
+ *   given by polybench_task_edge as communications.
+ *
+ * POLYBENCH_VERIFY checks the output of the kernel without printing it:
+ * "checksum" prints a checksum of each output array, "save:<file>"
+ * saves them to a binary reference file and "compare:<file>" compares
+ * them with the reference, within POLYBENCH_VERIFY_ULPS,
+ * POLYBENCH_VERIFY_RTOL and POLYBENCH_VERIFY_ATOL (see polybench.c).
+ *
+ * With any instrumentation, POLYBENCH_RECORD=<file> appends a record of
+ * the run to <file>, as CSV if its name ends in .csv and as one JSON
+ * object per line otherwise: kernel, variant, dataset (POLYBENCH_DATASET
+ * of the benchmark header, or "custom") and sizes, OpenMP threads and
+ * their CPUs, compiler and -DPOLYBENCH_COMPILE_FLAGS, timing statistics
+ * and counter values.
  *
  * See README or utilities/polybench.c for additional options.
  *
@@ -25,7 +112,14 @@
 
 # include <stdlib.h>
 
-/* Array padding. By default, none is used. */
+/* Array padding. By default, none is used. With
+   -DPOLYBENCH_RUNTIME_PADDING, it is read from POLYBENCH_PADDING at run
+   time, and the arrays become variable-length (see polybench.c). */
+# ifdef POLYBENCH_RUNTIME_PADDING
+#  undef POLYBENCH_PADDING_FACTOR
+#  define POLYBENCH_PADDING_FACTOR polybench_get_padding()
+extern int polybench_get_padding();
+# endif
 # ifndef POLYBENCH_PADDING_FACTOR
 /* default: */
 #  define POLYBENCH_PADDING_FACTOR 0
@@ -50,6 +144,21 @@
 # endif
 
 
+/* Schedule of the worksharing loops. By default, the schedule written
+   in the kernel, POLYBENCH_SCHEDULE(kind) for schedule(kind) or
+   POLYBENCH_SCHEDULE_DEFAULT for the default schedule. With
+   -DPOLYBENCH_RUNTIME_SCHEDULE, all of them become schedule(runtime),
+   set with OMP_SCHEDULE. */
+# ifdef POLYBENCH_RUNTIME_SCHEDULE
+#  define POLYBENCH_SCHEDULE(...) schedule(runtime)
+#  define POLYBENCH_SCHEDULE_DEFAULT schedule(runtime)
+# else
+/* default: */
+#  define POLYBENCH_SCHEDULE(...) schedule(__VA_ARGS__)
+#  define POLYBENCH_SCHEDULE_DEFAULT
+# endif
+
+
 /* Macros to reference an array. Generic for heap and stack arrays
    (C99).  Each array dimensionality has his own macro, to be used at
    declaration or as a function argument.
@@ -59,7 +168,7 @@
 */
 # ifndef POLYBENCH_STACK_ARRAYS
 #  define POLYBENCH_ARRAY(x) *x
-#  define POLYBENCH_FREE_ARRAY(x) free((void*)x);
+#  define POLYBENCH_FREE_ARRAY(x) polybench_free_data((void*)x);
 #  define POLYBENCH_DECL_VAR(x) (*x)
 # else
 #  define POLYBENCH_ARRAY(x) x
@@ -80,15 +189,15 @@
 					  and returns a pointer to the 2d array
  */
 # define POLYBENCH_ALLOC_1D_ARRAY(n1, type)	\
-  (type(*)[n1 + POLYBENCH_PADDING_FACTOR])polybench_alloc_data (n1 + POLYBENCH_PADDING_FACTOR, sizeof(type))
+  (type(*)[n1 + POLYBENCH_PADDING_FACTOR])polybench_alloc_data ((unsigned long long) (n1 + POLYBENCH_PADDING_FACTOR), sizeof(type))
 # define POLYBENCH_ALLOC_2D_ARRAY(n1, n2, type)		\
-  (type(*)[n1 + POLYBENCH_PADDING_FACTOR][n2 + POLYBENCH_PADDING_FACTOR])polybench_alloc_data ((n1 + POLYBENCH_PADDING_FACTOR) * (n2 + POLYBENCH_PADDING_FACTOR), sizeof(type))
+  (type(*)[n1 + POLYBENCH_PADDING_FACTOR][n2 + POLYBENCH_PADDING_FACTOR])polybench_alloc_data ((unsigned long long) (n1 + POLYBENCH_PADDING_FACTOR) * (n2 + POLYBENCH_PADDING_FACTOR), sizeof(type))
 # define POLYBENCH_ALLOC_3D_ARRAY(n1, n2, n3, type)		\
-  (type(*)[n1 + POLYBENCH_PADDING_FACTOR][n2 + POLYBENCH_PADDING_FACTOR][n3 + POLYBENCH_PADDING_FACTOR])polybench_alloc_data ((n1 + POLYBENCH_PADDING_FACTOR) * (n2 + POLYBENCH_PADDING_FACTOR) * (n3 + POLYBENCH_PADDING_FACTOR), sizeof(type))
+  (type(*)[n1 + POLYBENCH_PADDING_FACTOR][n2 + POLYBENCH_PADDING_FACTOR][n3 + POLYBENCH_PADDING_FACTOR])polybench_alloc_data ((unsigned long long) (n1 + POLYBENCH_PADDING_FACTOR) * (n2 + POLYBENCH_PADDING_FACTOR) * (n3 + POLYBENCH_PADDING_FACTOR), sizeof(type))
 # define POLYBENCH_ALLOC_4D_ARRAY(n1, n2, n3, n4, type)			\
-  (type(*)[n1 + POLYBENCH_PADDING_FACTOR][n2 + POLYBENCH_PADDING_FACTOR][n3 + POLYBENCH_PADDING_FACTOR][n4 + POLYBENCH_PADDING_FACTOR])polybench_alloc_data ((n1 + POLYBENCH_PADDING_FACTOR) * (n2 + POLYBENCH_PADDING_FACTOR) * (n3 + POLYBENCH_PADDING_FACTOR) * (n4 + POLYBENCH_PADDING_FACTOR), sizeof(type))
+  (type(*)[n1 + POLYBENCH_PADDING_FACTOR][n2 + POLYBENCH_PADDING_FACTOR][n3 + POLYBENCH_PADDING_FACTOR][n4 + POLYBENCH_PADDING_FACTOR])polybench_alloc_data ((unsigned long long) (n1 + POLYBENCH_PADDING_FACTOR) * (n2 + POLYBENCH_PADDING_FACTOR) * (n3 + POLYBENCH_PADDING_FACTOR) * (n4 + POLYBENCH_PADDING_FACTOR), sizeof(type))
 # define POLYBENCH_ALLOC_5D_ARRAY(n1, n2, n3, n4, n5, type)		\
-  (type(*)[n1 + POLYBENCH_PADDING_FACTOR][n2 + POLYBENCH_PADDING_FACTOR][n3 + POLYBENCH_PADDING_FACTOR][n4 + POLYBENCH_PADDING_FACTOR][n5 + POLYBENCH_PADDING_FACTOR])polybench_alloc_data ((n1 + POLYBENCH_PADDING_FACTOR) * (n2 + POLYBENCH_PADDING_FACTOR) * (n3 + POLYBENCH_PADDING_FACTOR) * (n4 + POLYBENCH_PADDING_FACTOR) * (n5 + POLYBENCH_PADDING_FACTOR), sizeof(type))
+  (type(*)[n1 + POLYBENCH_PADDING_FACTOR][n2 + POLYBENCH_PADDING_FACTOR][n3 + POLYBENCH_PADDING_FACTOR][n4 + POLYBENCH_PADDING_FACTOR][n5 + POLYBENCH_PADDING_FACTOR])polybench_alloc_data ((unsigned long long) (n1 + POLYBENCH_PADDING_FACTOR) * (n2 + POLYBENCH_PADDING_FACTOR) * (n3 + POLYBENCH_PADDING_FACTOR) * (n4 + POLYBENCH_PADDING_FACTOR) * (n5 + POLYBENCH_PADDING_FACTOR), sizeof(type))
 
 /* Macros for array declaration. */
 # ifndef POLYBENCH_STACK_ARRAYS
@@ -121,6 +230,20 @@
 # endif
 
 
+/* Problem sizes. The compile-time value of a size can be overridden at
+   run time with --<name>=<value> on the command line or with
+   POLYBENCH_<name> in the environment, e.g. --N=500 or POLYBENCH_N=500.
+   Without POLYBENCH_USE_C99_PROTO, the arrays keep their compile-time
+   dimensions, which are then the largest accepted sizes.
+   POLYBENCH_PARAM is for parameters which are not array dimensions. */
+# ifdef POLYBENCH_USE_C99_PROTO
+#  define POLYBENCH_SIZE(x) polybench_get_size (argc, argv, #x, x, 0)
+# else
+#  define POLYBENCH_SIZE(x) polybench_get_size (argc, argv, #x, x, x)
+# endif
+# define POLYBENCH_PARAM(x) polybench_get_size (argc, argv, #x, x, 0)
+
+
 /* Dead-code elimination macros. Use argc/argv for the run-time check. */
 # ifndef POLYBENCH_DUMP_ARRAYS
 #  define POLYBENCH_DCE_ONLY_CODE    if (argc > 42 && ! strcmp(argv[0], ""))
@@ -133,11 +256,86 @@
   func
 
 
+/* Output verification. Checks the live-out arrays of the kernel as
+   selected with POLYBENCH_VERIFY (see polybench.c). The arrays are of
+   float or double, and may be padded. */
+# define polybench_verify_1d(x, n1)					\
+  polybench_verify (#x, POLYBENCH_ARRAY(x),				\
+		    sizeof(POLYBENCH_ARRAY(x)[0]), 1, n1, n1)
+# define polybench_verify_2d(x, n1, n2)					\
+  polybench_verify (#x, POLYBENCH_ARRAY(x),				\
+		    sizeof(POLYBENCH_ARRAY(x)[0][0]), n1, n2,		\
+		    sizeof(POLYBENCH_ARRAY(x)[0])				\
+		    / sizeof(POLYBENCH_ARRAY(x)[0][0]))
+
+
+/* Region tracing. With -DPOLYBENCH_TRACE, the regions delimited by
+   polybench_region_begin/end (with the same name) and the timed runs
+   ("kernel") are written to a Paraver trace at exit. */
+# ifdef POLYBENCH_TRACE
+#  define polybench_region_begin(name)					\
+  do {									\
+    static int polybench_region_id = 0;					\
+    if (! polybench_region_id)						\
+      polybench_region_id = polybench_trace_region (name);		\
+    polybench_trace_event (polybench_region_id, 1);			\
+  } while (0)
+#  define polybench_region_end(name)					\
+  do {									\
+    static int polybench_region_id = 0;					\
+    if (! polybench_region_id)						\
+      polybench_region_id = polybench_trace_region (name);		\
+    polybench_trace_event (polybench_region_id, 0);			\
+  } while (0)
+#  define polybench_trace_start polybench_trace_run (); polybench_region_begin ("kernel");
+#  define polybench_trace_stop polybench_region_end ("kernel");
+/* Task tracing. polybench_task_begin/end (with the same name) delimit
+   the body of the task id, a non-negative integer unique in the run,
+   and polybench_task_edge records that task to depends on task from,
+   through a flow dependency or an anti-dependency: the trace shows the
+   task graph as communications from the end of from to the beginning
+   of to. */
+#  define polybench_task_begin(name, id)				\
+  do {									\
+    static int polybench_region_id = 0;					\
+    if (! polybench_region_id)						\
+      polybench_region_id = polybench_trace_region (name);		\
+    polybench_trace_task (polybench_region_id, id, 1);			\
+  } while (0)
+#  define polybench_task_end(name, id)					\
+  do {									\
+    static int polybench_region_id = 0;					\
+    if (! polybench_region_id)						\
+      polybench_region_id = polybench_trace_region (name);		\
+    polybench_trace_task (polybench_region_id, id, 0);			\
+  } while (0)
+#  define polybench_task_edge(from, to) polybench_trace_edge (from, to)
+extern void polybench_trace_run();
+extern int polybench_trace_region(const char* name);
+extern void polybench_trace_event(int region, int begin);
+extern void polybench_trace_task(int region, long long id, int begin);
+extern void polybench_trace_edge(long long from, long long to);
+# else
+#  define polybench_region_begin(name)
+#  define polybench_region_end(name)
+#  define polybench_task_begin(name, id) ((void) (id))
+#  define polybench_task_end(name, id) ((void) (id))
+#  define polybench_task_edge(from, to) ((void) (from), (void) (to))
+#  define polybench_trace_start
+#  define polybench_trace_stop
+# endif
+
+
 /* Performance-related instrumentation. See polybench.c */
-# define polybench_start_instruments
-# define polybench_stop_instruments
+# define polybench_start_instruments polybench_trace_start
+# define polybench_stop_instruments polybench_trace_stop
 # define polybench_print_instruments
 
+/* Repetition of the kernel. Prefixes the block which initializes the
+   data and runs the kernel between the start and stop instruments.
+   By default, the block is executed once. */
+# define polybench_repeat
+
 
 /* PAPI support. */
 # ifdef POLYBENCH_PAPI
@@ -147,7 +345,22 @@ extern const unsigned int polybench_papi_eventlist[];
 #  undef polybench_print_instruments
 #  define polybench_set_papi_thread_report(x)	\
    polybench_papi_counters_threadid = x;
-#  define polybench_start_instruments				\
+#  ifndef POLYBENCH_PAPI_SERIALIZE
+/* All the events are counted on every thread in a single run. */
+#   define polybench_start_instruments		\
+  polybench_prepare_instruments();		\
+  polybench_papi_init();			\
+  polybench_papi_start_group();			\
+  polybench_trace_start
+
+#   define polybench_stop_instruments		\
+  polybench_trace_stop				\
+  polybench_papi_stop_group();			\
+  polybench_papi_close();
+
+#  else
+/* One run of the kernel per event, on a single thread. */
+#   define polybench_start_instruments				\
   polybench_prepare_instruments();				\
   polybench_papi_init();					\
   int evid;							\
@@ -155,13 +368,40 @@ extern const unsigned int polybench_papi_eventlist[];
     {								\
       if (polybench_papi_start_counter(evid))			\
 	continue;						\
+      polybench_trace_start					\
 
-#  define polybench_stop_instruments		\
+#   define polybench_stop_instruments		\
+      polybench_trace_stop			\
       polybench_papi_stop_counter(evid);	\
     }						\
   polybench_papi_close();			\
 
-#  define polybench_print_instruments polybench_papi_print();
+#  endif
+#  define polybench_print_instruments		\
+  polybench_papi_print();			\
+  polybench_record_run (POLYBENCH_DATASET);
+# endif
+
+
+/* Linux perf_event_open support. */
+# ifdef POLYBENCH_PERF
+#  ifdef POLYBENCH_PAPI
+#   error "POLYBENCH_PERF and POLYBENCH_PAPI are exclusive"
+#  endif
+#  undef polybench_start_instruments
+#  undef polybench_stop_instruments
+#  undef polybench_print_instruments
+#  define polybench_start_instruments		\
+  polybench_prepare_instruments();		\
+  polybench_perf_init();			\
+  polybench_perf_start();			\
+  polybench_trace_start
+#  define polybench_stop_instruments		\
+  polybench_trace_stop				\
+  polybench_perf_stop();
+#  define polybench_print_instruments		\
+  polybench_perf_print();			\
+  polybench_record_run (POLYBENCH_DATASET);
 # endif
 
 
@@ -170,13 +410,35 @@ extern const unsigned int polybench_papi_eventlist[];
 #  undef polybench_start_instruments
 #  undef polybench_stop_instruments
 #  undef polybench_print_instruments
-#  define polybench_start_instruments polybench_timer_start();
-#  define polybench_stop_instruments polybench_timer_stop();
-#  define polybench_print_instruments polybench_timer_print();
-extern double polybench_program_total_flops;
+#  undef polybench_repeat
+#  define polybench_start_instruments		\
+  polybench_timer_start();			\
+  polybench_trace_start
+#  define polybench_stop_instruments		\
+  polybench_trace_stop				\
+  polybench_timer_stop();
+#  define polybench_print_instruments		\
+  polybench_timer_print();			\
+  polybench_record_run (POLYBENCH_DATASET);
+#  define polybench_repeat					\
+  for (polybench_repeat_init (); polybench_repeat_next (); )
 extern void polybench_timer_start();
 extern void polybench_timer_stop();
 extern void polybench_timer_print();
+extern void polybench_repeat_init();
+extern int polybench_repeat_next();
+# endif
+
+/* Per-thread time stamps, taken by every thread of a parallel region
+   around a worksharing loop with nowait, to report the arrival skew of
+   the threads at the next barrier (see polybench.c). */
+# if defined(POLYBENCH_TIME) || defined(POLYBENCH_GFLOPS)
+#  define polybench_thread_begin() polybench_thread_stamp (0)
+#  define polybench_thread_end() polybench_thread_stamp (1)
+extern void polybench_thread_stamp(int end);
+# else
+#  define polybench_thread_begin()
+#  define polybench_thread_end()
 # endif
 
 /* Function declaration. */
@@ -193,10 +455,36 @@ extern void polybench_papi_stop_counter(int evid);
 extern void polybench_papi_init();
 extern void polybench_papi_close();
 extern void polybench_papi_print();
+#  ifndef POLYBENCH_PAPI_SERIALIZE
+extern void polybench_papi_start_group();
+extern void polybench_papi_stop_group();
+#  endif
+# endif
+
+# ifdef POLYBENCH_PERF
+extern void polybench_prepare_instruments();
+extern void polybench_perf_init();
+extern void polybench_perf_start();
+extern void polybench_perf_stop();
+extern void polybench_perf_print();
 # endif
 
+/* Flop count and compulsory memory traffic of the kernel, set by the
+   program before running it, for -DPOLYBENCH_GFLOPS and
+   -DPOLYBENCH_ROOFLINE. */
+# define polybench_set_program_flops(x) polybench_program_total_flops = (x)
+# define polybench_set_program_bytes(x) polybench_program_total_bytes = (x)
+extern double polybench_program_total_flops;
+extern double polybench_program_total_bytes;
+
 /* Function prototypes. */
-extern void* polybench_alloc_data(unsigned long long int n, int elt_size);
+extern int polybench_get_size(int argc, char** argv, const char* name,
+			      int def, int max);
+extern void polybench_record_run(const char* dataset);
+extern void polybench_verify(const char* name, void* data, int elt_size,
+			     long long rows, long long cols, long long ld);
+extern void* polybench_alloc_data(unsigned long long int n, size_t elt_size);
+extern void polybench_free_data(void* ptr);
 
 
 #endif /* !POLYBENCH_H */
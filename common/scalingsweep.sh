@@ -0,0 +1,85 @@
+#!/bin/bash
+# Run a polybench kernel with 1..N OpenMP threads under several thread
+# placement policies, and print one CSV line per run with the POP
+# efficiencies: bind,places,threads,seconds,speedup,GE,PE,LB,SerE,CompS.
+#
+# usage: scalingsweep.sh <binary> [max_threads] [bind:places ...]
+#
+# The binary must be built with -DPOLYBENCH_TIME. The thread counts are
+# the powers of two up to max_threads (default: the number of CPUs),
+# and max_threads itself. The policies are OMP_PROC_BIND:OMP_PLACES
+# pairs (default: false: close:cores spread:cores). The other POLYBENCH_*
+# variables (sizes, POLYBENCH_REPETITIONS...) are passed through.
+#
+# For each policy, with P threads and T(P) the run time:
+#   speedup    S = T(1) / T(P)
+#   GE         global efficiency, S / P = PE * CompS
+#   PE         parallel efficiency, LB * SerE (see polybench.c)
+#   LB         load balance of the useful times
+#   SerE       serialization efficiency
+#   CompS      computation scalability, useful time with 1 thread over
+#              the total useful time with P threads
+
+if [ $# -lt 1 ]; then
+    echo "usage: $0 <binary> [max_threads] [bind:places ...]" >&2
+    exit 1
+fi
+binary=$1
+max=${2:-`nproc`}
+shift
+[ $# -gt 0 ] && shift
+policies=${@:-"false: close:cores spread:cores"}
+
+threads=""
+p=1
+while [ $p -lt $max ]; do
+    threads="$threads $p"
+    p=$((p * 2))
+done
+threads="$threads $max"
+
+# The useful time of a thread is its CPU time: the waiting threads must
+# sleep instead of spinning.
+export OMP_WAIT_POLICY=passive
+export POLYBENCH_POP=1
+
+echo "bind,places,threads,seconds,speedup,GE,PE,LB,SerE,CompS"
+for policy in $policies; do
+    bind=${policy%%:*}
+    places=${policy#*:}
+    t1=""
+    u1=""
+    for p in $threads; do
+        if [ -n "$places" ]; then
+            export OMP_PLACES=$places
+        else
+            unset OMP_PLACES
+        fi
+        out=`OMP_NUM_THREADS=$p OMP_PROC_BIND=$bind $binary 2>/dev/null`
+        pop=`echo "$out" | grep '^\[PolyBench\]\[pop\]'`
+        if [ -z "$pop" ]; then
+            echo "$0: $binary failed with $p threads ($policy)" >&2
+            exit 1
+        fi
+        echo "$pop" | awk -v bind=$bind -v places=$places -v p=$p \
+            -v t1=$t1 -v u1=$u1 '
+        {
+            for (i = 2; i <= NF; i++) {
+                split ($i, kv, "=");
+                v[kv[1]] = kv[2] + 0;
+            }
+            t = v["runtime"];
+            u = v["useful_sum"];
+            if (t1 == "") { t1 = t; u1 = u }
+            s = t > 0 ? t1 / t : 0;
+            cs = u > 0 ? u1 / u : 0;
+            printf "%s,%s,%d,%.6f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f\n",
+                bind, places, p, t, s, 100 * s / p, v["PE"], v["LB"],
+                v["SerE"], 100 * cs;
+        }'
+        if [ -z "$t1" ]; then
+            t1=`echo "$pop" | sed 's/.*runtime=\([^ ]*\).*/\1/'`
+            u1=`echo "$pop" | sed 's/.*useful_sum=\([^ ]*\).*/\1/'`
+        fi
+    done
+done
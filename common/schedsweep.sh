@@ -0,0 +1,98 @@
+#!/bin/bash
+# Run a polybench kernel under a range of OpenMP loop schedules and
+# thread counts, print one CSV line per run:
+# kernel,variant,threads,schedule,seconds,speedup, and report the best
+# schedule for each thread count on stderr.
+#
+# usage: schedsweep.sh <binary> [threads] [chunks] [variant ...]
+#
+# The binary must be built with -DPOLYBENCH_TIME and
+# -DPOLYBENCH_RUNTIME_SCHEDULE, so that all its worksharing loops take
+# their schedule from OMP_SCHEDULE, e.g.
+#   make FLAGS="-g -DPOLYBENCH_TIME -DPOLYBENCH_RUNTIME_SCHEDULE"
+# threads and chunks are comma separated lists (default: the powers of
+# two up to the number of CPUs, and 1,2,4,8,16,32,64). The schedules
+# are static (one block per thread), auto, and static, dynamic, guided
+# and nonmonotonic:dynamic with each chunk size. The speedup is over
+# the static schedule with the same thread count. Each variant is
+# another binary of the kernel that splits its loops itself (e.g.
+# trmm_v2 and trmm_v3): it is run once per thread count and reported
+# with the "partition" schedule (and OMP_SCHEDULE=static for any loop
+# left to the runtime), against the same static baseline. The
+# other POLYBENCH_* variables (sizes, POLYBENCH_REPETITIONS...) are
+# passed through; with repetitions, the median time is used.
+
+if [ $# -lt 1 ]; then
+    echo "usage: $0 <binary> [threads] [chunks] [variant ...]" >&2
+    exit 1
+fi
+binary=$1
+if [ -n "$2" ]; then
+    threads=`echo $2 | tr , ' '`
+else
+    threads=""
+    p=1
+    while [ $p -lt `nproc` ]; do
+        threads="$threads $p"
+        p=$((p * 2))
+    done
+    threads="$threads `nproc`"
+fi
+chunks=`echo ${3:-1,2,4,8,16,32,64} | tr , ' '`
+shift $(($# < 3 ? $# : 3))
+variants="$*"
+kernel=`basename $binary`
+variant=`echo $kernel | sed -n 's/.*_\(v[0-9]*\)$/\1/p'`
+kernel=${kernel%_v[0-9]*}
+
+schedules="static auto"
+for kind in static dynamic guided nonmonotonic:dynamic; do
+    for c in $chunks; do
+        schedules="$schedules $kind,$c"
+    done
+done
+
+echo "kernel,variant,threads,schedule,seconds,speedup"
+for p in $threads; do
+    base=""
+    best=""
+    best_seconds=""
+    for s in $schedules; do
+        out=`OMP_NUM_THREADS=$p OMP_SCHEDULE=$s $binary 2>/dev/null`
+        if ! echo "$out" | grep -q '^\[PolyBench\] schedule='; then
+            echo "$0: $binary failed with $p threads ($s), or was not" \
+                "built with -DPOLYBENCH_RUNTIME_SCHEDULE" >&2
+            exit 1
+        fi
+        seconds=`echo "$out" | tail -n 1`
+        [ -z "$base" ] && base=$seconds
+        awk -v k=$kernel -v v=$variant -v p=$p -v s=$s -v sec=$seconds \
+            -v base=$base 'BEGIN {
+            printf "%s,%s,%d,\"%s\",%s,%.2f\n", k, v, p, s, sec,
+                (sec > 0 ? base / sec : 0) }'
+        if [ -z "$best" ] || \
+            awk -v a=$seconds -v b=$best_seconds 'BEGIN { exit !(a < b) }'; then
+            best=$s
+            best_seconds=$seconds
+        fi
+    done
+    for b in $variants; do
+        v=`basename $b | sed -n 's/.*_\(v[0-9]*\)$/\1/p'`
+        if ! out=`OMP_SCHEDULE=static OMP_NUM_THREADS=$p $b 2>/dev/null`; then
+            echo "$0: $b failed with $p threads" >&2
+            exit 1
+        fi
+        seconds=`echo "$out" | tail -n 1`
+        awk -v k=$kernel -v v=$v -v p=$p -v sec=$seconds -v base=$base 'BEGIN {
+            printf "%s,%s,%d,\"partition\",%s,%.2f\n", k, v, p, sec,
+                (sec > 0 ? base / sec : 0) }'
+        if awk -v a=$seconds -v b=$best_seconds 'BEGIN { exit !(a < b) }'; then
+            best="partition of $v"
+            best_seconds=$seconds
+        fi
+    done
+    awk -v k=$kernel -v v=$variant -v p=$p -v s="$best" -v sec=$best_seconds \
+        -v base=$base 'BEGIN {
+        printf "%s %s, %d threads: best schedule %s, %s s (%.2fx static)\n",
+            k, v, p, s, sec, (sec > 0 ? base / sec : 0) }' >&2
+done
@@ -0,0 +1,52 @@
+#!/bin/bash
+# Run a polybench kernel over a geometric range of problem sizes and
+# print one CSV line per size: kernel,size,seconds,gflops.
+#
+# usage: sizesweep.sh <binary> [min] [max] [factor]
+#
+# The binary must be built with -DPOLYBENCH_TIME, and with
+# -DPOLYBENCH_USE_C99_PROTO to go beyond its compile-time dataset, e.g.
+#   make FLAGS="-g -DPOLYBENCH_TIME -DPOLYBENCH_USE_C99_PROTO"
+# Every dimension of the kernel is set to the same size. The other
+# POLYBENCH_* variables (POLYBENCH_REPETITIONS, POLYBENCH_TSTEPS...) are
+# passed through; with repetitions, the median time is used.
+
+if [ $# -lt 1 ]; then
+    echo "usage: $0 <binary> [min] [max] [factor]" >&2
+    exit 1
+fi
+binary=$1
+min=${2:-32}
+max=${3:-4000}
+factor=${4:-2}
+kernel=`basename $binary`
+kernel=${kernel%_v[0-9]*}
+
+# Size parameters and flop count of each kernel, as a function of s
+# (and t, the number of time steps).
+export POLYBENCH_TSTEPS=${POLYBENCH_TSTEPS:-10}
+case $kernel in
+    correlation)     params="N M";        flops="s*s*(s-1) + 6*s*s" ;;
+    trmm)            params="NI";         flops="3*s*s*(s-1)/2" ;;
+    bicg)            params="NX NY";      flops="4*s*s" ;;
+    jacobi-2d-imper) params="N";          flops="5*t*(s-2)*(s-2)" ;;
+    2mm)             params="NI NJ NK NL"; flops="5*s*s*s + s*s" ;;
+    *) echo "$0: unknown kernel $kernel" >&2; exit 1 ;;
+esac
+
+echo "kernel,size,seconds,gflops"
+size=$min
+while [ $size -le $max ]; do
+    for p in $params; do
+        export POLYBENCH_$p=$size
+    done
+    seconds=`$binary 2>/dev/null | tail -n 1`
+    if [ -z "$seconds" ]; then
+        echo "$0: $binary failed for size $size" >&2
+        exit 1
+    fi
+    awk -v k=$kernel -v s=$size -v t=$POLYBENCH_TSTEPS -v sec=$seconds \
+        "BEGIN { f = $flops; printf \"%s,%d,%s,%.3f\n\", k, s, sec, (sec > 0 ? f / sec / 1e9 : 0) }"
+    next=`awk -v s=$size -v f=$factor 'BEGIN { n = int(s * f); print (n > s ? n : s + 1) }'`
+    size=$next
+done